@@ -0,0 +1,237 @@
+// Benchmark program for the MD_Menu library
+//
+// Measures the time taken by runMenu() for each navigation keypress on the 
+// target hardware, to compare changes to the library or menu definitions.
+// The menus are navigated from scripts and the results printed to the 
+// Serial Monitor. The display callback does nothing, so the times are for 
+// the library code only.
+//
+// Cases:
+//   wide   one menu with BENCH_BLOCKS*10 items, INC through all of them and DEC back
+//   list   pick list with BENCH_BLOCKS*10 entries, INC through all of them
+//   int    integer edit, INC and DEC through BENCH_BLOCKS*10 values
+//   float  float edit, INC and DEC through BENCH_BLOCKS*10 values
+//   getListItem  direct extraction of the last entry of the pick list
+//
+// The host build in extras/host has an equivalent benchmark (Menu_Bench) 
+// that also counts callbacks and PROGMEM reads.
+//
+#include <MD_Menu.h>
+
+const uint32_t BAUD_RATE = 57600;   // Serial Monitor speed setting
+
+// Number of blocks of 10 items in the test menu and list (1-11)
+#define BENCH_BLOCKS 11
+
+// Callbacks
+MD_Menu::userNavAction_t navigation(uint16_t &incDelta);
+bool display(MD_Menu::userDisplayAction_t action, char *msg);
+MD_Menu::value_t *valueRqst(MD_Menu::mnuId_t id, bool bGet);
+
+// Menu definitions built from blocks of 10 items ----
+#define ITM(n)  { n, "Item " #n, MD_Menu::MNU_INPUT, 1 }
+#define ITM10(b) ITM(b##0), ITM(b##1), ITM(b##2), ITM(b##3), ITM(b##4), \
+                 ITM(b##5), ITM(b##6), ITM(b##7), ITM(b##8), ITM(b##9)
+
+#define LST10(b) "L" #b "0|L" #b "1|L" #b "2|L" #b "3|L" #b "4|" \
+                 "L" #b "5|L" #b "6|L" #b "7|L" #b "8|L" #b "9"
+
+const PROGMEM MD_Menu::mnuHeader_t mnuHdr[] =
+{
+  { 1, "Bench", 1, 4, 0 },
+  { 2, "Wide", 10, (BENCH_BLOCKS * 10) + 9, 0 },
+};
+
+const PROGMEM MD_Menu::mnuItem_t mnuItm[] =
+{
+  { 1, "Integer", MD_Menu::MNU_INPUT, 1 },
+  { 2, "List",    MD_Menu::MNU_INPUT, 2 },
+  { 3, "Float",   MD_Menu::MNU_INPUT, 3 },
+  { 4, "Wide",    MD_Menu::MNU_MENU,  2 },
+  ITM10(1),
+#if BENCH_BLOCKS > 1
+  ITM10(2),
+#endif
+#if BENCH_BLOCKS > 2
+  ITM10(3),
+#endif
+#if BENCH_BLOCKS > 3
+  ITM10(4),
+#endif
+#if BENCH_BLOCKS > 4
+  ITM10(5),
+#endif
+#if BENCH_BLOCKS > 5
+  ITM10(6),
+#endif
+#if BENCH_BLOCKS > 6
+  ITM10(7),
+#endif
+#if BENCH_BLOCKS > 7
+  ITM10(8),
+#endif
+#if BENCH_BLOCKS > 8
+  ITM10(9),
+#endif
+#if BENCH_BLOCKS > 9
+  ITM10(10),
+#endif
+#if BENCH_BLOCKS > 10
+  ITM10(11),
+#endif
+};
+
+const PROGMEM char listBench[] = LST10(0)
+#if BENCH_BLOCKS > 1
+  "|" LST10(1)
+#endif
+#if BENCH_BLOCKS > 2
+  "|" LST10(2)
+#endif
+#if BENCH_BLOCKS > 3
+  "|" LST10(3)
+#endif
+#if BENCH_BLOCKS > 4
+  "|" LST10(4)
+#endif
+#if BENCH_BLOCKS > 5
+  "|" LST10(5)
+#endif
+#if BENCH_BLOCKS > 6
+  "|" LST10(6)
+#endif
+#if BENCH_BLOCKS > 7
+  "|" LST10(7)
+#endif
+#if BENCH_BLOCKS > 8
+  "|" LST10(8)
+#endif
+#if BENCH_BLOCKS > 9
+  "|" LST10(9)
+#endif
+#if BENCH_BLOCKS > 10
+  "|" LST10(10)
+#endif
+  ;
+
+const PROGMEM MD_Menu::mnuInput_t mnuInp[] =
+{
+  { 1, "Int",   MD_Menu::INP_INT,   valueRqst, 9, -1000000, 0, 1000000, 0, 10, nullptr, 0 },
+  { 2, "List",  MD_Menu::INP_LIST,  valueRqst, 6, 0, 0, 0, 0, 0, listBench, 0 },
+  { 3, "Float", MD_Menu::INP_FLOAT, valueRqst, 9, -1000000, 0, 1000000, 0, 10, nullptr, 0 },
+};
+
+MD_Menu M(navigation, display,        // user navigation and display
+          mnuHdr, ARRAY_SIZE(mnuHdr), // menu header data
+          mnuItm, ARRAY_SIZE(mnuItm), // menu item data
+          mnuInp, ARRAY_SIZE(mnuInp));// menu input data
+
+// Scripted navigation ----
+const char *script;             // current position in the script
+MD_Menu::value_t vBuf;          // interface buffer for values
+
+MD_Menu::userNavAction_t navigation(uint16_t &incDelta)
+{
+  incDelta = 1;
+  switch (*script)
+  {
+  case '+': script++; return(MD_Menu::NAV_INC);
+  case '-': script++; return(MD_Menu::NAV_DEC);
+  case 's': script++; return(MD_Menu::NAV_SEL);
+  case 'e': script++; return(MD_Menu::NAV_ESC);
+  }
+
+  return(MD_Menu::NAV_NULL);
+}
+
+bool display(MD_Menu::userDisplayAction_t action, char *msg)
+{
+  return(true);
+}
+
+MD_Menu::value_t *valueRqst(MD_Menu::mnuId_t id, bool bGet)
+{
+  if (bGet) { vBuf.value = 0; vBuf.power = 0; }
+  return(&vBuf);
+}
+
+// Benchmark ----
+char *makeScript(char *buf, const char *head, char c1, uint16_t n1, char c2, uint16_t n2)
+// Script of head followed by n1 c1 and n2 c2 characters
+{
+  char *p = buf;
+
+  strcpy(p, head); p += strlen(head);
+  memset(p, c1, n1); p += n1;
+  memset(p, c2, n2); p += n2;
+  *p = '\0';
+
+  return(buf);
+}
+
+void run(const __FlashStringHelper *name, const char *nav)
+// Run the script from the root menu and print the average and maximum 
+// time for each key. The keys to reach the test case are included.
+{
+  uint16_t keys = 0;
+  uint32_t total = 0, worst = 0;
+
+  script = nav;
+  M.runMenu(true);
+  while (*script != '\0' && M.isInMenu())
+  {
+    uint32_t t = micros();
+
+    M.runMenu();
+    t = micros() - t;
+    keys++;
+    total += t;
+    if (t > worst) worst = t;
+  }
+  M.reset();
+
+  Serial.print(name);
+  Serial.print(F("\t"));
+  Serial.print(keys);
+  Serial.print(F("\t"));
+  Serial.print(keys == 0 ? 0 : total / keys);
+  Serial.print(F("\t"));
+  Serial.println(worst);
+}
+
+void setup(void)
+{
+  const uint16_t n = BENCH_BLOCKS * 10;
+  static char buf[(2 * n) + 8];
+
+  Serial.begin(BAUD_RATE);
+  Serial.print(F("\n[Menu_Bench] "));
+  Serial.print(n);
+  Serial.println(F(" items"));
+  Serial.println(F("case\tkeys\tavg us\tmax us"));
+
+  M.begin();
+
+  run(F("wide"),  makeScript(buf, "+++s", '+', n - 1, '-', n - 1));
+  run(F("list"),  makeScript(buf, "+s", '+', n - 1, '-', 0));
+  run(F("int"),   makeScript(buf, "s", '+', n, '-', n));
+  run(F("float"), makeScript(buf, "++s", '+', n, '-', n));
+
+  // getListItem is public so can be timed directly
+  {
+    const uint16_t reps = 100;
+    char item[8];
+    uint32_t t = micros();
+
+    for (uint16_t i = 0; i < reps; i++)
+      M.getListItem(listBench, n - 1, item, sizeof(item));
+    t = micros() - t;
+    Serial.print(F("getListItem\t"));
+    Serial.print(reps);
+    Serial.print(F("\t"));
+    Serial.print(t / reps);
+    Serial.println(F("\t-"));
+  }
+}
+
+void loop(void) {}
@@ -114,18 +114,18 @@ const PROGMEM char engUnit[] = "Hz";
 
 const PROGMEM MD_Menu::mnuInput_t mnuInp[] =
 {
-  { 10, "List", MD_Menu::INP_LIST, mnuLValueRqst, 6, 0, 0, 0, 0, 0, listFruit }, // shorter and longer list labels
-  { 11, "Bool", MD_Menu::INP_BOOL, mnuBValueRqst, 1, 0, 0, 0, 0, 0, nullptr },
-  { 12, "Int8", MD_Menu::INP_INT, mnuIValueRqst, 4, -128, 0, 127, 0, 10, nullptr },
-  { 13, "Int16", MD_Menu::INP_INT, mnuIValueRqst, 4, -32768, 0, 32767, 0, 10, nullptr },  // test field too small
-  { 14, "Int32", MD_Menu::INP_INT, mnuIValueRqst, 6, -66636, 0, 65535, 0, 10, nullptr },
-  { 15, "Hex16", MD_Menu::INP_INT, mnuIValueRqst, 4, 0x0000, 0, 0xffff, 0, 16, nullptr },  // test hex display
-  { 16, "Float", MD_Menu::INP_FLOAT, mnuFValueRqst, 7, -10000, 0, 99950, 0, 10, nullptr },  // test float number
-  { 17, "Eng", MD_Menu::INP_ENGU, mnuEValueRqst, 7, 0, 0, 999000, 3, 50, engUnit },  // test engineering units number
-  { 18, "Confirm", MD_Menu::INP_RUN, myCode, 0, 0, 0, 0, 0, 10, nullptr },
-
-  { 40, "Confirm", MD_Menu::INP_RUN, myLEDCode, 0, 0, 0, 0, 0, 0, nullptr },  // test using index in run code
-  { 41, "Confirm", MD_Menu::INP_RUN, myLEDCode, 0, 0, 0, 0, 0, 0, nullptr },
+  { 10, "List", MD_Menu::INP_LIST, mnuLValueRqst, 6, 0, 0, 0, 0, 0, listFruit, 0 }, // shorter and longer list labels
+  { 11, "Bool", MD_Menu::INP_BOOL, mnuBValueRqst, 1, 0, 0, 0, 0, 0, nullptr, 0 },
+  { 12, "Int8", MD_Menu::INP_INT, mnuIValueRqst, 4, -128, 0, 127, 0, 10, nullptr, 0 },
+  { 13, "Int16", MD_Menu::INP_INT, mnuIValueRqst, 4, -32768, 0, 32767, 0, 10, nullptr, 0 },  // test field too small
+  { 14, "Int32", MD_Menu::INP_INT, mnuIValueRqst, 6, -66636, 0, 65535, 0, 10, nullptr, 0 },
+  { 15, "Hex16", MD_Menu::INP_INT, mnuIValueRqst, 4, 0x0000, 0, 0xffff, 0, 16, nullptr, 0 },  // test hex display
+  { 16, "Float", MD_Menu::INP_FLOAT, mnuFValueRqst, 7, -10000, 0, 99950, 0, 10, nullptr, 0 },  // test float number
+  { 17, "Eng", MD_Menu::INP_ENGU, mnuEValueRqst, 7, 0, 0, 999000, 3, 50, engUnit, 0 },  // test engineering units number
+  { 18, "Confirm", MD_Menu::INP_RUN, myCode, 0, 0, 0, 0, 0, 10, nullptr, 0 },
+
+  { 40, "Confirm", MD_Menu::INP_RUN, myLEDCode, 0, 0, 0, 0, 0, 0, nullptr, 0 },  // test using index in run code
+  { 41, "Confirm", MD_Menu::INP_RUN, myLEDCode, 0, 0, 0, 0, 0, 0, nullptr, 0 },
 };
 
 // bring it all together in the global menu object
@@ -315,6 +315,7 @@ bool display(MD_Menu::userDisplayAction_t action, char *msg)
     break;
 
   case MD_Menu::DISP_CLEAR:
+    lcd.noCursor();
     lcd.clear();
     break;
 
@@ -326,11 +327,30 @@ bool display(MD_Menu::userDisplayAction_t action, char *msg)
     break;
 
   case MD_Menu::DISP_L1:
+    lcd.noCursor();
     lcd.setCursor(0, 1);
     lcd.print(szLine);
     lcd.setCursor(0, 1);
     lcd.print(msg);
     break;
+
+  case MD_Menu::DISP_SPAN:
+    lcd.noCursor();
+    lcd.setCursor(M.getDisplayColumn(), M.getDisplayLine());
+    lcd.print(msg);
+    break;
+
+  case MD_Menu::DISP_CURSOR:
+    lcd.setCursor(M.getDisplayColumn(), M.getDisplayLine());
+    lcd.cursor();
+    break;
+
+  case MD_Menu::DISP_LINE:    // only for LCD_ROWS > 2 and M.setDisplayLines(LCD_ROWS)
+    lcd.setCursor(0, M.getDisplayLine());
+    lcd.print(szLine);
+    lcd.setCursor(0, M.getDisplayLine());
+    lcd.print(msg);
+    break;
   }
 
   return(true);
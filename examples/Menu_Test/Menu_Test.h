@@ -21,6 +21,8 @@ const uint16_t MENU_TIMEOUT = 5000; // in milliseconds
 
 const uint8_t LED_PIN = LED_BUILTIN;  // for myLEDCode function
 
+extern MD_Menu M;   // the menu object, for display requests with extra parameters
+
 // Function prototypes for Navigation/Display
 void setupNav(void);
 bool display(MD_Menu::userDisplayAction_t, char* = nullptr);
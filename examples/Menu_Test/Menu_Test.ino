@@ -120,29 +120,29 @@ const PROGMEM char engUnit[] = "Hz";
 
 const PROGMEM MD_Menu::mnuInput_t mnuInp[] =
 {
-  { 10, "List",     MD_Menu::INP_LIST,  mnuListValueRqst, 6,       0, 0,      0, 0,  0, listFruit }, // shorter and longer list labels
-  { 11, "Bool",     MD_Menu::INP_BOOL,  mnuBoolValueRqst, 1,       0, 0,      0, 0,  0, nullptr },
-  { 12, "Int8",     MD_Menu::INP_INT,   mnuIntValueRqst,  4,    -128, 0,    127, 0, 10, nullptr },
-  { 13, "Int16",    MD_Menu::INP_INT,   mnuIntValueRqst,  4,  -32768, 0,  32767, 0, 10, nullptr },  // test field too small
-  { 14, "Int32",    MD_Menu::INP_INT,   mnuIntValueRqst,  6,  -65536, 0,  65535, 0, 10, nullptr },
-  { 15, "Hex16",    MD_Menu::INP_INT,   mnuIntValueRqst,  4,  0x0000, 0, 0xffff, 0, 16, nullptr },  // test hex display
-  { 16, "Float",    MD_Menu::INP_FLOAT, mnuFloatValueRqst,7,  -10000, 0,  99950, 0, 10, nullptr },  // test float number
-  { 17, "EU",       MD_Menu::INP_ENGU,  mnuEngValueRqst,  7,   -1100, 0,   1500, 0, 50, engUnit },  // test engineering units number
-  { 18, "Extern",   MD_Menu::INP_EXT,   mnuExtValueRqst,  6,  -65536, 0,  65535, 0, 10, nullptr },  // test externally provided data
-  { 19, "Confirm",  MD_Menu::INP_RUN,   myCode,           0,       0, 0,      0, 0, 10, nullptr },
-
-  { 30, "Port",     MD_Menu::INP_LIST, mnuSerialValueRqst, 4, 0, 0, 0, 0, 0, listCOM },
-  { 31, "Bits/s",   MD_Menu::INP_LIST, mnuSerialValueRqst, 6, 0, 0, 0, 0, 0, listBaud },
-  { 32, "Parity",   MD_Menu::INP_LIST, mnuSerialValueRqst, 1, 0, 0, 0, 0, 0, listParity },
-  { 33, "No. Bits", MD_Menu::INP_LIST, mnuSerialValueRqst, 1, 0, 0, 0, 0, 0, listStop },
-
-  { 40, "Confirm", MD_Menu::INP_RUN, myLEDCode, 0, 0, 0, 0, 0, 0, nullptr },  // test using index in run code
-  { 41, "Confirm", MD_Menu::INP_RUN, myLEDCode, 0, 0, 0, 0, 0, 0, nullptr },
-
-  { 50, "Flip",    MD_Menu::INP_INT, mnuFFValueRqst, 4, -128, 0, 127, 0, 10, nullptr },
-  { 51, "Flop",    MD_Menu::INP_INT, mnuFFValueRqst, 4, -128, 0, 127, 0, 16, nullptr },
-
-  { 60, "Text",    MD_Menu::INP_RUN,  myCode,  0, 0, 0, 0, 0, 10, nullptr },  // test output TXT
+  { 10, "List",     MD_Menu::INP_LIST,  mnuListValueRqst, 6,       0, 0,      0, 0,  0, listFruit, 0 }, // shorter and longer list labels
+  { 11, "Bool",     MD_Menu::INP_BOOL,  mnuBoolValueRqst, 1,       0, 0,      0, 0,  0, nullptr, 0 },
+  { 12, "Int8",     MD_Menu::INP_INT,   mnuIntValueRqst,  4,    -128, 0,    127, 0, 10, nullptr, 0 },
+  { 13, "Int16",    MD_Menu::INP_INT,   mnuIntValueRqst,  4,  -32768, 0,  32767, 0, 10, nullptr, 0 },  // test field too small
+  { 14, "Int32",    MD_Menu::INP_INT,   mnuIntValueRqst,  6,  -65536, 0,  65535, 0, 10, nullptr, 0 },
+  { 15, "Hex16",    MD_Menu::INP_INT,   mnuIntValueRqst,  4,  0x0000, 0, 0xffff, 0, 16, nullptr, 0 },  // test hex display
+  { 16, "Float",    MD_Menu::INP_FLOAT, mnuFloatValueRqst,7,  -10000, 0,  99950, 0, 10, nullptr, 0 },  // test float number
+  { 17, "EU",       MD_Menu::INP_ENGU,  mnuEngValueRqst,  7,   -1100, 0,   1500, 0, 50, engUnit, 0 },  // test engineering units number
+  { 18, "Extern",   MD_Menu::INP_EXT,   mnuExtValueRqst,  6,  -65536, 0,  65535, 0, 10, nullptr, 0 },  // test externally provided data
+  { 19, "Confirm",  MD_Menu::INP_RUN,   myCode,           0,       0, 0,      0, 0, 10, nullptr, 0 },
+
+  { 30, "Port",     MD_Menu::INP_LIST, mnuSerialValueRqst, 4, 0, 0, 0, 0, 0, listCOM, 0 },
+  { 31, "Bits/s",   MD_Menu::INP_LIST, mnuSerialValueRqst, 6, 0, 0, 0, 0, 0, listBaud, 0 },
+  { 32, "Parity",   MD_Menu::INP_LIST, mnuSerialValueRqst, 1, 0, 0, 0, 0, 0, listParity, 0 },
+  { 33, "No. Bits", MD_Menu::INP_LIST, mnuSerialValueRqst, 1, 0, 0, 0, 0, 0, listStop, 0 },
+
+  { 40, "Confirm", MD_Menu::INP_RUN, myLEDCode, 0, 0, 0, 0, 0, 0, nullptr, 0 },  // test using index in run code
+  { 41, "Confirm", MD_Menu::INP_RUN, myLEDCode, 0, 0, 0, 0, 0, 0, nullptr, 0 },
+
+  { 50, "Flip",    MD_Menu::INP_INT, mnuFFValueRqst, 4, -128, 0, 127, 0, 10, nullptr, 0 },
+  { 51, "Flop",    MD_Menu::INP_INT, mnuFFValueRqst, 4, -128, 0, 127, 0, 16, nullptr, 0 },
+
+  { 60, "Text",    MD_Menu::INP_RUN,  myCode,  0, 0, 0, 0, 0, 10, nullptr, 0 },  // test output TXT
 };
 
 // bring it all together in the global menu object
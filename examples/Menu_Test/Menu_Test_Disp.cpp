@@ -32,6 +32,29 @@ bool display(MD_Menu::userDisplayAction_t action, char *msg)
     Serial.print("\n1> ");
     Serial.print(msg);
     break;
+
+  case MD_Menu::DISP_SPAN:
+    Serial.print("\n");
+    Serial.print(M.getDisplayLine());
+    Serial.print("@");
+    Serial.print(M.getDisplayColumn());
+    Serial.print("> ");
+    Serial.print(msg);
+    break;
+
+  case MD_Menu::DISP_CURSOR:
+    Serial.print("\n^ ");
+    Serial.print(M.getDisplayLine());
+    Serial.print("@");
+    Serial.print(M.getDisplayColumn());
+    break;
+
+  case MD_Menu::DISP_LINE:
+    Serial.print("\n");
+    Serial.print(M.getDisplayLine());
+    Serial.print("> ");
+    Serial.print(msg);
+    break;
   }
 
   return(true);
@@ -73,6 +96,7 @@ bool display(MD_Menu::userDisplayAction_t action, char *msg)
     break;
   
   case MD_Menu::DISP_CLEAR:
+    lcd.noCursor();
     lcd.clear();
     break;
 
@@ -84,11 +108,30 @@ bool display(MD_Menu::userDisplayAction_t action, char *msg)
     break;
 
   case MD_Menu::DISP_L1:
+    lcd.noCursor();
     lcd.setCursor(0, 1);
     lcd.print(szLine);
     lcd.setCursor(0, 1);
     lcd.print(msg);
     break;
+
+  case MD_Menu::DISP_SPAN:
+    lcd.noCursor();
+    lcd.setCursor(M.getDisplayColumn(), M.getDisplayLine());
+    lcd.print(msg);
+    break;
+
+  case MD_Menu::DISP_CURSOR:
+    lcd.setCursor(M.getDisplayColumn(), M.getDisplayLine());
+    lcd.cursor();
+    break;
+
+  case MD_Menu::DISP_LINE:    // only for LCD_ROWS > 2 and M.setDisplayLines(LCD_ROWS)
+    lcd.setCursor(0, M.getDisplayLine());
+    lcd.print(szLine);
+    lcd.setCursor(0, M.getDisplayLine());
+    lcd.print(msg);
+    break;
   }
 
   return(true);
@@ -134,6 +177,7 @@ bool display(MD_Menu::userDisplayAction_t action, char* msg)
     break;
 
   case MD_Menu::DISP_CLEAR:
+    lcd.noCursor();
     lcd.clear();
     break;
 
@@ -145,11 +189,30 @@ bool display(MD_Menu::userDisplayAction_t action, char* msg)
     break;
 
   case MD_Menu::DISP_L1:
+    lcd.noCursor();
     lcd.setCursor(0, 1);
     lcd.print(szLine);
     lcd.setCursor(0, 1);
     lcd.print(msg);
     break;
+
+  case MD_Menu::DISP_SPAN:
+    lcd.noCursor();
+    lcd.setCursor(M.getDisplayColumn(), M.getDisplayLine());
+    lcd.print(msg);
+    break;
+
+  case MD_Menu::DISP_CURSOR:
+    lcd.setCursor(M.getDisplayColumn(), M.getDisplayLine());
+    lcd.cursor();
+    break;
+
+  case MD_Menu::DISP_LINE:    // only for LCD_ROWS > 2 and M.setDisplayLines(LCD_ROWS)
+    lcd.setCursor(0, M.getDisplayLine());
+    lcd.print(szLine);
+    lcd.setCursor(0, M.getDisplayLine());
+    lcd.print(msg);
+    break;
   }
 
   return(b);
@@ -174,6 +237,7 @@ bool display(MD_Menu::userDisplayAction_t action, char* msg)
 #define LINE1_Y  0
 #define LINE2_X  0      // Line 2 coordinates for start of text
 #define LINE2_Y  (LINE_HEIGHT + 2)
+#define OLED_LINES 6    // Number of text lines on the display
 
 // Declaration a SSD1306 display connected using I2C
 static Adafruit_SSD1306 oled(OLED_WIDTH, OLED_HEIGHT, &Wire, OLED_RESET);
@@ -195,6 +259,9 @@ bool display(MD_Menu::userDisplayAction_t action, char *msg)
       oled.setTextSize(FONT_SCALE);
       oled.setTextColor(SSD1306_WHITE);
       oled.display();
+#if MNU_MULTI_LINE    // set to 1 in MD_Menu.h to show a window of menu items
+      M.setDisplayLines(OLED_LINES);
+#endif
     }
     break;
 
@@ -218,6 +285,35 @@ bool display(MD_Menu::userDisplayAction_t action, char *msg)
     oled.print(msg);
     oled.display();
     break;
+
+  case MD_Menu::DISP_SPAN:
+    // clear the changed part of the line, put cursor in position and print the message
+    {
+      int16_t x = (M.getDisplayLine() == 0 ? LINE1_X : LINE2_X) + (M.getDisplayColumn() * 6 * FONT_SCALE);
+      int16_t y = (M.getDisplayLine() == 0 ? LINE1_Y : LINE2_Y);
+
+      oled.fillRect(x, y, strlen(msg) * 6 * FONT_SCALE, LINE_HEIGHT, SSD1306_BLACK);
+      oled.setCursor(x, y);
+      oled.print(msg);
+      oled.display();
+    }
+    break;
+
+  case MD_Menu::DISP_CURSOR:
+    // no edit cursor shown on this display
+    break;
+
+  case MD_Menu::DISP_LINE:
+    // lines after the first 2 follow on from line 2
+    {
+      int16_t y = (M.getDisplayLine() == 0 ? LINE1_Y : LINE2_Y + ((M.getDisplayLine() - 1) * LINE_HEIGHT));
+
+      oled.fillRect(LINE2_X, y, OLED_WIDTH - LINE2_X, LINE_HEIGHT, SSD1306_BLACK);
+      oled.setCursor(LINE2_X, y);
+      oled.print(msg);
+      oled.display();
+    }
+    break;
   }
 
   return(b);
@@ -264,6 +360,9 @@ bool display(MD_Menu::userDisplayAction_t action, char* msg)
   case MD_Menu::DISP_L1:
     P.print(msg);
     break;
+
+  default:  // no partial line updates for this display
+    break;
   }
 
   return(true);
@@ -0,0 +1,28 @@
+// Minimal Arduino API shim for building MD_Menu on a host (Linux) system
+//
+// See Arduino.h for more information
+
+#include <Arduino.h>
+#include <time.h>
+
+Print Serial;
+uint32_t hostProgmemBytes = 0;
+
+static uint32_t timeOffset = 0;   // virtual time added by delay()
+
+static uint64_t hostMicros(void)
+{
+  static uint64_t start = 0;
+  struct timespec ts;
+  uint64_t t;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  t = ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+  if (start == 0) start = t;
+
+  return(t - start);
+}
+
+uint32_t millis(void) { return((uint32_t)(hostMicros() / 1000) + timeOffset); }
+uint32_t micros(void) { return((uint32_t)hostMicros() + (timeOffset * 1000)); }
+void delay(uint32_t ms) { timeOffset += ms; }
@@ -0,0 +1,57 @@
+#pragma once
+// Minimal Arduino API shim for building MD_Menu on a host (Linux) system
+//
+// Only the parts of the Arduino core used by the MD_Menu library are
+// provided. PROGMEM is ordinary memory on the host, so the program memory
+// access functions map to the standard library equivalents.
+//
+// Time is based on the host monotonic clock plus a virtual offset that is
+// moved forward by delay(), so that scripted tests can simulate the passing 
+// of time (eg, for menu timeouts) without actually waiting.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+// Program memory
+// The access functions count the bytes read so that benchmarks can 
+// report the PROGMEM traffic for each operation.
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s)    (s)
+
+extern uint32_t hostProgmemBytes;   ///< Count of bytes read using the PROGMEM access functions
+
+inline uint8_t pgm_read_byte(const void *p) { hostProgmemBytes++; return(*(const uint8_t *)p); }
+inline void *memcpy_P(void *d, const void *s, size_t n) { hostProgmemBytes += n; return(memcpy(d, s, n)); }
+inline size_t strlen_P(const char *s) { size_t n = strlen(s); hostProgmemBytes += n + 1; return(n); }
+inline char *strcpy_P(char *d, const char *s) { hostProgmemBytes += strlen(s) + 1; return(strcpy(d, s)); }
+inline char *strcat_P(char *d, const char *s) { hostProgmemBytes += strlen(s) + 1; return(strcat(d, s)); }
+inline int strcmp_P(const char *a, const char *b) { hostProgmemBytes += strlen(b) + 1; return(strcmp(a, b)); }
+inline int strncasecmp_P(const char *a, const char *b, size_t n) { hostProgmemBytes += n; return(strncasecmp(a, b, n)); }
+
+// Time
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+
+/**
+ * Print output to stdout, standing in for the Arduino Print/Serial classes.
+ */
+class Print
+{
+public:
+  void begin(uint32_t) {}
+  size_t print(const char *s) { return(fputs(s, stdout) >= 0 ? strlen(s) : 0); }
+  size_t print(char c) { return(putchar(c) != EOF); }
+  size_t print(int v) { return(printf("%d", v)); }
+  size_t print(unsigned int v) { return(printf("%u", v)); }
+  size_t print(long v) { return(printf("%ld", v)); }
+  size_t print(unsigned long v) { return(printf("%lu", v)); }
+  size_t println(void) { return(print('\n')); }
+  template<typename T> size_t println(T v) { size_t n = print(v); return(n + println()); }
+};
+
+extern Print Serial;
@@ -0,0 +1,322 @@
+// Host (Linux) benchmark for the MD_Menu library
+//
+// Builds synthetic menus of different shapes and sizes and drives them
+// through scripted navigation sequences, reporting for each keypress
+// - the average and worst case time spent in runMenu()
+// - the number of display and value request callbacks
+// - the number of bytes read from PROGMEM (counted by the host shim)
+//
+// Usage: Menu_Bench [size ...]
+//   size  number of items/list entries for each case (default 10 100 1000 2000).
+//         Sizes are limited to the range of MD_Menu::mnuId_t and MD_Menu::listId_t
+//         (see MNU_ID_BITS and MNU_LIST_BITS).
+//
+// Cases:
+//   wide   one menu with size items, INC through all of them and DEC back
+//   deep   nested menus MNU_STACK_SIZE deep with size items in total,
+//          SEL down to the deepest level and ESC back up
+//   list   pick list with size entries, INC through all of them
+//   int    integer edit, INC and DEC size times (numeric formatting)
+//   float  float edit, INC and DEC size times (numeric formatting)
+//   getListItem  direct extraction of the last entry of a size entry list
+
+#include <MD_Menu.h>
+#include <chrono>
+
+// Nav script and statistics
+static const char *script = nullptr;
+static uint32_t countDisp = 0;
+static uint32_t countValue = 0;
+static MD_Menu::value_t vBuf;
+
+MD_Menu::userNavAction_t navigation(uint16_t &incDelta)
+{
+  incDelta = 1;
+  if (script == nullptr || *script == '\0') return(MD_Menu::NAV_NULL);
+
+  switch (*script++)
+  {
+  case '+': return(MD_Menu::NAV_INC);
+  case '-': return(MD_Menu::NAV_DEC);
+  case 's': return(MD_Menu::NAV_SEL);
+  case 'e': return(MD_Menu::NAV_ESC);
+  }
+
+  return(MD_Menu::NAV_NULL);
+}
+
+bool display(MD_Menu::userDisplayAction_t action, char *msg)
+{
+  countDisp++;
+  return(true);
+}
+
+MD_Menu::value_t *valueRqst(MD_Menu::mnuId_t id, bool bGet)
+{
+  countValue++;
+  if (bGet) { vBuf.value = 0; vBuf.power = 0; }
+  return(&vBuf);
+}
+
+// Synthetic menu tables
+// PROGMEM is ordinary memory on the host so the tables can be built at run time.
+static MD_Menu::mnuHeader_t *mnuHdr = nullptr;
+static MD_Menu::mnuItem_t *mnuItm = nullptr;
+static MD_Menu::mnuInput_t *mnuInp = nullptr;
+static char *list = nullptr;
+static MD_Menu::mnuId_t cntHdr, cntItm, cntInp;
+
+static void freeTables(void)
+{
+  free(mnuHdr); mnuHdr = nullptr;
+  free(mnuItm); mnuItm = nullptr;
+  free(mnuInp); mnuInp = nullptr;
+  free(list); list = nullptr;
+}
+
+static void setItem(MD_Menu::mnuItem_t *mi, MD_Menu::mnuId_t id, MD_Menu::mnuAction_t action, MD_Menu::mnuId_t actionId)
+{
+  mi->id = id;
+  snprintf(mi->label, sizeof(mi->label), "Item %d", id);
+  mi->action = action;
+  mi->actionId = actionId;
+}
+
+static void setInput(MD_Menu::mnuInput_t *mp, MD_Menu::mnuId_t id, MD_Menu::inputAction_t action, const char *pList)
+{
+  memset(mp, 0, sizeof(MD_Menu::mnuInput_t));
+  mp->id = id;
+  strcpy(mp->label, "Value");
+  mp->action = action;
+  mp->cbVR = valueRqst;
+  mp->fieldWidth = 9;
+  mp->range[0].value = -1000000;
+  mp->range[1].value = 1000000;
+  mp->base = 10;
+  mp->pList = pList;
+}
+
+static void buildWide(uint16_t n)
+// One menu with n items, all editing the same integer input
+{
+  freeTables();
+  cntHdr = 1; cntItm = n; cntInp = 1;
+  mnuHdr = (MD_Menu::mnuHeader_t *)calloc(cntHdr, sizeof(MD_Menu::mnuHeader_t));
+  mnuItm = (MD_Menu::mnuItem_t *)calloc(cntItm, sizeof(MD_Menu::mnuItem_t));
+  mnuInp = (MD_Menu::mnuInput_t *)calloc(cntInp, sizeof(MD_Menu::mnuInput_t));
+
+  mnuHdr[0] = { 1, "Wide", 1, (MD_Menu::mnuId_t)n, 0 };
+  for (uint16_t i = 0; i < n; i++)
+    setItem(&mnuItm[i], i + 1, MD_Menu::MNU_INPUT, 1);
+  setInput(&mnuInp[0], 1, MD_Menu::INP_INT, nullptr);
+}
+
+static void buildDeep(uint16_t n)
+// MNU_STACK_SIZE nested menus sharing n items. The first item of each
+// menu leads to the next level, the rest edit an integer input.
+// The item table is in reverse order so lookups scan the most records.
+{
+  uint16_t perLevel = n / MNU_STACK_SIZE;
+
+  freeTables();
+  if (perLevel < 1) perLevel = 1;
+  cntHdr = MNU_STACK_SIZE; cntItm = perLevel * MNU_STACK_SIZE; cntInp = 1;
+  mnuHdr = (MD_Menu::mnuHeader_t *)calloc(cntHdr, sizeof(MD_Menu::mnuHeader_t));
+  mnuItm = (MD_Menu::mnuItem_t *)calloc(cntItm, sizeof(MD_Menu::mnuItem_t));
+  mnuInp = (MD_Menu::mnuInput_t *)calloc(cntInp, sizeof(MD_Menu::mnuInput_t));
+
+  for (uint8_t level = 0; level < MNU_STACK_SIZE; level++)
+  {
+    MD_Menu::mnuId_t idStart = (level * perLevel) + 1;
+
+    mnuHdr[level].id = level + 1;
+    snprintf(mnuHdr[level].label, sizeof(mnuHdr[level].label), "Level %d", level);
+    mnuHdr[level].idItmStart = idStart;
+    mnuHdr[level].idItmEnd = idStart + perLevel - 1;
+    for (uint16_t i = 0; i < perLevel; i++)
+    {
+      bool isMenu = (i == 0 && level < MNU_STACK_SIZE - 1);
+
+      setItem(&mnuItm[cntItm - 1 - (idStart - 1 + i)], idStart + i,
+        isMenu ? MD_Menu::MNU_MENU : MD_Menu::MNU_INPUT, isMenu ? level + 2 : 1);
+    }
+  }
+  setInput(&mnuInp[0], 1, MD_Menu::INP_INT, nullptr);
+}
+
+static void buildList(uint16_t n)
+// One menu item editing a pick list with n entries
+{
+  char *p;
+
+  freeTables();
+  cntHdr = 1; cntItm = 1; cntInp = 1;
+  mnuHdr = (MD_Menu::mnuHeader_t *)calloc(cntHdr, sizeof(MD_Menu::mnuHeader_t));
+  mnuItm = (MD_Menu::mnuItem_t *)calloc(cntItm, sizeof(MD_Menu::mnuItem_t));
+  mnuInp = (MD_Menu::mnuInput_t *)calloc(cntInp, sizeof(MD_Menu::mnuInput_t));
+  list = (char *)malloc((n * 8) + 1);
+
+  p = list;
+  for (uint16_t i = 0; i < n; i++)
+    p += sprintf(p, "%sL%05d", (i == 0 ? "" : "|"), i);
+
+  mnuHdr[0] = { 1, "List", 1, 1, 0 };
+  setItem(&mnuItm[0], 1, MD_Menu::MNU_INPUT, 1);
+  setInput(&mnuInp[0], 1, MD_Menu::INP_LIST, list);
+}
+
+static void buildValue(MD_Menu::inputAction_t action)
+// One menu item editing a numeric value
+{
+  freeTables();
+  cntHdr = 1; cntItm = 1; cntInp = 1;
+  mnuHdr = (MD_Menu::mnuHeader_t *)calloc(cntHdr, sizeof(MD_Menu::mnuHeader_t));
+  mnuItm = (MD_Menu::mnuItem_t *)calloc(cntItm, sizeof(MD_Menu::mnuItem_t));
+  mnuInp = (MD_Menu::mnuInput_t *)calloc(cntInp, sizeof(MD_Menu::mnuInput_t));
+
+  mnuHdr[0] = { 1, "Value", 1, 1, 0 };
+  setItem(&mnuItm[0], 1, MD_Menu::MNU_INPUT, 1);
+  setInput(&mnuInp[0], 1, action, nullptr);
+}
+
+static char *makeScript(const char *head, char c1, uint16_t n1, char c2, uint16_t n2)
+// Build a script of head followed by n1 c1 and n2 c2 characters
+{
+  char *s = (char *)malloc(strlen(head) + n1 + n2 + 1);
+  char *p = s;
+
+  strcpy(p, head); p += strlen(head);
+  memset(p, c1, n1); p += n1;
+  memset(p, c2, n2); p += n2;
+  *p = '\0';
+
+  return(s);
+}
+
+static void run(const char *name, uint16_t size, const char *nav)
+// Run the script with the current tables and report the results.
+// Only runMenu() calls that process a navigation action are counted.
+{
+#if MNU_DEF_LOCAL
+  MD_Menu M(navigation, display, mnuHdr, cntHdr, mnuItm, cntItm, mnuInp, cntInp);
+#else
+  MD_Menu::mnuDef_t def = { mnuHdr, cntHdr, mnuItm, cntItm, mnuInp, cntInp };  // indices built by begin() are not released
+  MD_Menu M(navigation, display, def);
+#endif
+  uint32_t keys = 0;
+  uint32_t disp = 0, value = 0, bytes = 0;
+  double total = 0, worst = 0;
+
+  M.begin();
+  script = nav;
+  M.runMenu(true);
+
+  while (*script != '\0' && M.isInMenu())
+  {
+    countDisp = countValue = 0;
+    hostProgmemBytes = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    M.runMenu();
+    auto t1 = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+
+    keys++;
+    total += us;
+    if (us > worst) worst = us;
+    disp += countDisp;
+    value += countValue;
+    bytes += hostProgmemBytes;
+  }
+
+  if (keys == 0) keys = 1;
+  printf("%-12s %6u %6u %10.3f %10.3f %8.2f %8.2f %10.1f\n", name, size, keys,
+    total / keys, worst, (double)disp / keys, (double)value / keys, (double)bytes / keys);
+}
+
+int main(int argc, char *argv[])
+{
+  static const uint16_t defSizes[] = { 10, 100, 1000, 2000 };
+  const uint32_t idMax = (1UL << ((sizeof(MD_Menu::mnuId_t) * 8) - 1)) - 2;  // largest usable id
+  const uint32_t listMax = (1UL << (sizeof(MD_Menu::listId_t) * 8)) - 1;      // largest list size
+  uint16_t sizes[16];
+  uint8_t nSizes = 0;
+
+  for (int i = 1; i < argc && nSizes < ARRAY_SIZE(sizes); i++)
+    sizes[nSizes++] = atoi(argv[i]);
+  if (nSizes == 0)
+    for (uint8_t i = 0; i < ARRAY_SIZE(defSizes); i++)
+      sizes[nSizes++] = defSizes[i];
+
+  printf("%-12s %6s %6s %10s %10s %8s %8s %10s\n", "case", "size", "keys", "avg us", "max us", "disp/k", "cbVR/k", "PROGMEM/k");
+
+  for (uint8_t i = 0; i < nSizes; i++)
+  {
+    uint16_t n = sizes[i];      // size for menu cases
+    uint16_t nList = sizes[i];  // size for list cases
+    char *s;
+
+    if (n < 1) continue;
+    if (n > idMax)
+    {
+      printf("# size %u limited to %lu by mnuId_t\n", n, (unsigned long)idMax);
+      n = idMax;
+    }
+    if (nList > listMax)
+    {
+      printf("# list size %u limited to %lu by listId_t\n", nList, (unsigned long)listMax);
+      nList = listMax;
+    }
+
+    buildWide(n);
+    s = makeScript("", '+', n - 1, '-', n - 1);
+    run("wide", n, s);
+    free(s);
+
+    buildDeep(n);
+    s = makeScript("", 's', MNU_STACK_SIZE - 1, 'e', MNU_STACK_SIZE - 1);
+    run("deep", n, s);
+    free(s);
+
+    buildList(nList);
+    s = makeScript("s", '+', nList - 1, '-', 0);
+    run("list", nList, s);
+    free(s);
+
+    buildValue(MD_Menu::INP_INT);
+    s = makeScript("s", '+', n, '-', n);
+    run("int", n, s);
+    free(s);
+
+    buildValue(MD_Menu::INP_FLOAT);
+    s = makeScript("s", '+', n, '-', n);
+    run("float", n, s);
+    free(s);
+
+    // getListItem is public so can be timed directly
+    buildList(nList);
+    {
+#if MNU_DEF_LOCAL
+      MD_Menu M(navigation, display, mnuHdr, cntHdr, mnuItm, cntItm, mnuInp, cntInp);
+#else
+      MD_Menu::mnuDef_t def = { mnuHdr, cntHdr, mnuItm, cntItm, mnuInp, cntInp };
+      MD_Menu M(navigation, display, def);
+#endif
+      const uint16_t reps = 1000;
+      char buf[10];
+
+      hostProgmemBytes = 0;
+      auto t0 = std::chrono::steady_clock::now();
+      for (uint16_t r = 0; r < reps; r++)
+        M.getListItem(list, nList - 1, buf, sizeof(buf));
+      auto t1 = std::chrono::steady_clock::now();
+      printf("%-12s %6u %6u %10.3f %10s %8s %8s %10.1f\n", "getListItem", nList, reps,
+        std::chrono::duration<double, std::micro>(t1 - t0).count() / reps, "-", "-", "-",
+        (double)hostProgmemBytes / reps);
+    }
+  }
+
+  freeTables();
+
+  return(0);
+}
@@ -0,0 +1,515 @@
+// Host (Linux) scripted driver for the MD_Menu library
+//
+// Runs a menu definition similar to the Menu_Test example from a script of
+// navigation actions and prints the display requests and value changes to
+// stdout, so that the menu logic can be checked and profiled without hardware.
+//
+// Usage: Menu_Host [-w] [-d] [-l lines] [-f] [-s file] [-t timeout] [-a interval] [-b interval] [-n delta] [-o target] [-y] [-p] [-i] [-r] [script]
+//   -w          set menu wrap
+//   -d          set display diffing (needs MNU_DISP_DIFF)
+//   -l lines    set the number of display lines (needs MNU_MULTI_LINE)
+//   -f          compose the display in a frame buffer, printed once per runMenu() (needs MNU_FRAME)
+//   -s file     keep the fruit list, Int8 and Float values in a persistent store in the file (needs MNU_STORE)
+//   -t timeout  set menu timeout in milliseconds
+//   -a interval set numeric input acceleration for events interval milliseconds apart (needs MNU_ACCEL)
+//   -b interval limit real time feedback to one value request every interval milliseconds (needs MNU_FB_RATE)
+//   -n delta    incDelta for the script INC and DEC events (default 1)
+//   -o target   open the menu at target instead of the root (needs MNU_PARENT_MAP).
+//               target is m (menu header), i (menu item) or n (input) followed by the id, eg i22
+//   -y          value requests are asynchronous, completed by the c script character (needs MNU_ASYNC)
+//   -p          print the activity statistics counters at the end (needs MNU_STATS)
+//   -i          use the index tables generated at compile time (needs MNU_INDEX)
+//   -r          use RAM copies of the index tables generated at compile time (needs MNU_INDEX)
+//   script      navigation script. Read from stdin if not specified.
+//
+// Script characters:
+//   +  NAV_INC       -  NAV_DEC
+//   s  NAV_SEL       e  NAV_ESC
+//   .  no navigation input
+//   t  advance the time by 1 second, no navigation input
+//   c  complete the pending value request (-y), no navigation input
+//   ?c type ahead search for the character c, ?< removes the last
+//      search character (needs MNU_SEARCH)
+//   [..] the +, -, s and e characters between the brackets are posted to 
+//      the navigation queue and processed by one runMenu() pass (needs 
+//      MNU_NAV_QUEUE_SIZE)
+// All other characters are ignored. Each navigation character is one
+// pass through runMenu(). The menu is started at the beginning of the
+// script and the driver ends at the end of the script.
+
+#include <MD_Menu.h>
+#include <MD_Menu_Compile.h>
+#include <MD_MenuStore.h>
+#include <unistd.h>
+#include "StoreFile.h"
+
+static const char *script = nullptr;   // current script position
+static int32_t values[128];            // value storage for input ids
+static MD_Menu::value_t vBuf;          // interface buffer for values
+static uint16_t navDelta = 1;          // incDelta for the script events
+#if MNU_STATS
+static bool printStats = false;        // print the statistics at the end
+#endif
+
+const uint8_t FRAME_LINES_MAX = 8;     // display lines, and frame buffer size
+static uint8_t frameLines = 2;
+#if MNU_FRAME
+const uint8_t FRAME_COLS = 20;
+static char frame[FRAME_LINES_MAX * (FRAME_COLS + 1)];
+#endif
+
+const MD_Menu::mnuId_t storeIds[] = { 10, 12, 16 };   // persistent values
+MD_MenuStore store(storeIds, ARRAY_SIZE(storeIds), 256, storeFileIO);
+static bool useStore = false;
+
+#if MNU_ASYNC
+static bool useAsync = false;             // value requests completed by the script
+static MD_Menu::mnuId_t asyncId = -1;     // pending value request
+static bool asyncGet;
+#endif
+
+// Callbacks
+MD_Menu::userNavAction_t navigation(uint16_t &incDelta);
+bool display(MD_Menu::userDisplayAction_t action, char *msg);
+#if MNU_FRAME
+void frameReady(const char *frame);
+#endif
+MD_Menu::value_t *valueRqst(MD_Menu::mnuId_t id, bool bGet);
+MD_Menu::value_t *runCode(MD_Menu::mnuId_t id, bool bGet);
+MD_Menu::listId_t virtualItems(MD_Menu::mnuId_t id, MD_Menu::virtualRequest_t req, MD_Menu::listId_t idx, char *buf, uint8_t bufLen);
+
+// Menu Headers --------
+// The tables are constexpr so that they can be checked at compile time
+constexpr MD_Menu::mnuHeader_t mnuHdr[] PROGMEM =
+{
+  { 10, "MD_Menu",      10, 14, 0 },
+  { 11, "Input Data",   20, 29, 0 },
+  { 12, "Serial Setup", 30, 35, 0 },
+  { 13, "Realtime FB",  60, 63, 0 },
+};
+
+// Menu Items ----------
+constexpr MD_Menu::mnuItem_t mnuItm[] PROGMEM =
+{
+  // Starting (Root) menu
+  { 10, "Input Test",  MD_Menu::MNU_MENU, 11 },
+  { 11, "Serial",      MD_Menu::MNU_MENU, 12 },
+  { 12, "Realtime FB", MD_Menu::MNU_MENU, 13 },
+  { 13, "Run Code",    MD_Menu::MNU_INPUT, 19 },
+  { 14, "Profiles",    MD_Menu::MNU_VIRTUAL, 1 },
+
+  // Input Data submenu
+  { 20, "Fruit List", MD_Menu::MNU_INPUT, 10 },
+  { 21, "Boolean",    MD_Menu::MNU_INPUT, 11 },
+  { 22, "Integer 8",  MD_Menu::MNU_INPUT, 12 },
+  { 23, "Integer 16", MD_Menu::MNU_INPUT, 13 },
+  { 24, "Integer 32", MD_Menu::MNU_INPUT, 14 },
+  { 25, "Hex 16",     MD_Menu::MNU_INPUT, 15 },
+  { 26, "Float",      MD_Menu::MNU_INPUT, 16 },
+  { 27, "Eng Unit",   MD_Menu::MNU_INPUT, 17 },
+  { 28, "External",   MD_Menu::MNU_INPUT, 18 },
+  { 29, "Digit Edit", MD_Menu::MNU_INPUT, 20 },
+
+  // Serial Setup
+  { 30, "COM Port",  MD_Menu::MNU_INPUT, 30 },
+  { 31, "Speed",     MD_Menu::MNU_INPUT, 31 },
+  { 32, "Parity",    MD_Menu::MNU_INPUT, 32 },
+  { 33, "Stop Bits", MD_Menu::MNU_INPUT, 33 },
+  { 34, "Device",    MD_Menu::MNU_INPUT, 34 },
+  { 35, "Channel",   MD_Menu::MNU_INPUT, 35 },
+
+  // Realtime feedback variable edit
+  { 60, "Fruit List", MD_Menu::MNU_INPUT_FB, 10 },
+  { 61, "Boolean",    MD_Menu::MNU_INPUT_FB, 11 },
+  { 62, "Integer 8",  MD_Menu::MNU_INPUT_FB, 12 },
+  { 63, "Float",      MD_Menu::MNU_INPUT_FB, 16 },
+};
+
+// Input Items ---------
+const PROGMEM char listFruit[] = "Apple|Pear|Orange|Banana|Pineapple|Peach";
+const PROGMEM char listCOM[] = "COM1|COM2|COM3|COM4";
+const PROGMEM char listBaud[] = "9600|19200|57600|115200";
+const PROGMEM char listParity[] = "O|E|N";
+const PROGMEM char listStop[] = "0|1";
+const PROGMEM char listChan[] = "1|2|3|4|5|6|7|8|9|10|11|12|13|14|15|16|17|18|19|20|21|22|23|24|25|26|27|28|29|30|31|32|33|34|35|36|37|38|39|40";
+const PROGMEM char engUnit[] = "Hz";
+
+constexpr MD_Menu::mnuInput_t mnuInp[] PROGMEM =
+{
+  { 10, "List",     MD_Menu::INP_LIST,  valueRqst, 6,       0, 0,      0, 0,  0, listFruit, 0 },
+  { 11, "Bool",     MD_Menu::INP_BOOL,  valueRqst, 1,       0, 0,      0, 0,  0, nullptr, 0 },
+  { 12, "Int8",     MD_Menu::INP_INT,   valueRqst, 4,    -128, 0,    127, 0, 10, nullptr, 0 },
+  { 13, "Int16",    MD_Menu::INP_INT,   valueRqst, 4,  -32768, 0,  32767, 0, 10, nullptr, 0 },
+  { 14, "Int32",    MD_Menu::INP_INT,   valueRqst, 6,  -65536, 0,  65535, 0, 10, nullptr, 0 },
+  { 15, "Hex16",    MD_Menu::INP_INT,   valueRqst, 4,  0x0000, 0, 0xffff, 0, 16, nullptr, 0 },
+  { 16, "Float",    MD_Menu::INP_FLOAT, valueRqst, 7,  -10000, 0,  99950, 0, 10, nullptr, 0 },
+  { 17, "EU",       MD_Menu::INP_ENGU,  valueRqst, 7,   -1100, 0,   1500, 0, 50, engUnit, 0 },
+  { 18, "Extern",   MD_Menu::INP_EXT,   valueRqst, 6,  -65536, 0,  65535, 0, 10, nullptr, 0 },
+  { 19, "Confirm",  MD_Menu::INP_RUN,   runCode,   0,       0, 0,      0, 0, 10, nullptr, 0 },
+  { 20, "Digits",   MD_Menu::INP_INT,   valueRqst, 7,  -99999, 0,  99999, 0, 10, nullptr, MD_Menu::INP_OPT_DIGIT },
+
+  { 30, "Port",     MD_Menu::INP_LIST, valueRqst, 4, 0, 0, 0, 0, 0, listCOM, 0 },
+  { 31, "Bits/s",   MD_Menu::INP_LIST, valueRqst, 6, 0, 0, 0, 0, 0, listBaud, 0 },
+  { 32, "Parity",   MD_Menu::INP_LIST, valueRqst, 1, 0, 0, 0, 0, 0, listParity, 0 },
+  { 33, "No. Bits", MD_Menu::INP_LIST, valueRqst, 1, 0, 0, 0, 0, 0, listStop, 0 },
+  { 34, "Dev",      MD_Menu::INP_LIST, valueRqst, 8, 0, 0, 0, 0, 0, nullptr, 0 },   // virtual list
+  { 35, "Chan",     MD_Menu::INP_LIST, valueRqst, 2, 0, 0, 0, 0, 0, listChan, 0 },  // longer than the list cache
+};
+
+MD_MENU_VALIDATE(mnuHdr, mnuItm, mnuInp);
+
+#if MNU_INDEX
+MD_MENU_INDEX(idxHdr, mnuHdr);
+MD_MENU_INDEX(idxItm, mnuItm);
+MD_MENU_INDEX(idxInp, mnuInp);
+
+// RAM copies of the generated index tables (-r), owned by this program
+static MD_Menu::mnuId_t ramHdr[ARRAY_SIZE(idxHdr_pos.pos)];
+static MD_Menu::mnuId_t ramItm[ARRAY_SIZE(idxItm_pos.pos)];
+static MD_Menu::mnuId_t ramInp[ARRAY_SIZE(idxInp_pos.pos)];
+
+MD_Menu::mnuIndex_t ramIndex(const MD_Menu::mnuIndex_t &idx, MD_Menu::mnuId_t *pos)
+// Copy an index table into RAM
+{
+  MD_Menu::mnuIndex_t ram = idx;
+
+  memcpy(pos, idx.pos, idx.size * sizeof(MD_Menu::mnuId_t));
+  ram.pos = pos;
+  ram.inProgmem = false;
+
+  return(ram);
+}
+#endif
+
+// bring it all together in the global menu object
+#if MNU_DEF_LOCAL
+MD_Menu M(navigation, display,        // user navigation and display
+          mnuHdr, ARRAY_SIZE(mnuHdr), // menu header data
+          mnuItm, ARRAY_SIZE(mnuItm), // menu item data
+          mnuInp, ARRAY_SIZE(mnuInp));// menu input data
+#else
+MD_Menu::mnuDef_t menuDef =           // shared menu definition
+{
+  mnuHdr, ARRAY_SIZE(mnuHdr),
+  mnuItm, ARRAY_SIZE(mnuItm),
+  mnuInp, ARRAY_SIZE(mnuInp)
+};
+MD_Menu M(navigation, display, menuDef);
+#endif
+
+MD_Menu::userNavAction_t navigation(uint16_t &incDelta)
+// Take the next navigation action from the script
+{
+  MD_Menu::userNavAction_t nav = MD_Menu::NAV_NULL;
+
+  incDelta = navDelta;
+  while (*script != '\0')
+  {
+    switch (*script++)
+    {
+    case '+': nav = MD_Menu::NAV_INC;  break;
+    case '-': nav = MD_Menu::NAV_DEC;  break;
+    case 's': nav = MD_Menu::NAV_SEL;  break;
+    case 'e': nav = MD_Menu::NAV_ESC;  break;
+    case '.': return(MD_Menu::NAV_NULL);
+    case 't': delay(1000); return(MD_Menu::NAV_NULL);
+#if MNU_ASYNC
+    case 'c':   // complete the pending value request
+      if (asyncId != -1)
+      {
+        MD_Menu::mnuId_t id = asyncId;
+
+        asyncId = -1;
+        if (asyncGet)
+        {
+          vBuf.value = values[id];
+          vBuf.power = 0;
+        }
+        else
+        {
+          values[id] = vBuf.value;
+          printf("SET %d=%ld\n", id, (long)vBuf.value);
+        }
+        printf("COMPLETE %d\n", id);
+        M.completeValueRequest(id, &vBuf);
+      }
+      return(MD_Menu::NAV_NULL);
+#endif
+#if MNU_NAV_QUEUE_SIZE
+    case '[':   // queued events, posted before the next runMenu()
+      script--;
+      return(MD_Menu::NAV_NULL);
+#endif
+#if MNU_SEARCH
+    case '?':   // type ahead search character, no navigation input
+      if (*script != '\0')
+      {
+        char c = (*script == '<' ? '\b' : *script);
+
+        script++;
+        printf("SEARCH %s\n", M.searchItem(c) ? "found" : "no match");
+      }
+      return(MD_Menu::NAV_NULL);
+#endif
+    default: continue;    // ignore anything else
+    }
+    break;
+  }
+
+  return(nav);
+}
+
+#if MNU_NAV_QUEUE_SIZE
+void postEvents(void)
+// Post the events in a [..] group at the current script position
+{
+  if (*script != '[') return;
+
+  for (script++; *script != '\0' && *script != ']'; script++)
+  {
+    MD_Menu::userNavAction_t nav;
+
+    switch (*script)
+    {
+    case '+': nav = MD_Menu::NAV_INC; break;
+    case '-': nav = MD_Menu::NAV_DEC; break;
+    case 's': nav = MD_Menu::NAV_SEL; break;
+    case 'e': nav = MD_Menu::NAV_ESC; break;
+    default:  continue;   // ignore anything else
+    }
+    if (!M.postNav(nav))
+      printf("QUEUE full\n");
+  }
+  if (*script == ']') script++;
+}
+#endif
+
+bool display(MD_Menu::userDisplayAction_t action, char *msg)
+{
+  switch (action)
+  {
+  case MD_Menu::DISP_INIT:  break;
+  case MD_Menu::DISP_CLEAR: printf("CLS\n");           break;
+  case MD_Menu::DISP_L0:    printf("L0 [%s]\n", msg);  break;
+  case MD_Menu::DISP_L1:    printf("L1 [%s]\n", msg);  break;
+  case MD_Menu::DISP_SPAN:
+    printf("SPAN %d,%d [%s]\n", M.getDisplayLine(), M.getDisplayColumn(), msg);
+    break;
+  case MD_Menu::DISP_CURSOR:
+    printf("CURSOR %d,%d\n", M.getDisplayLine(), M.getDisplayColumn());
+    break;
+  case MD_Menu::DISP_LINE:
+    printf("L%d [%s]\n", M.getDisplayLine(), msg);
+    break;
+  }
+
+  return(true);
+}
+
+#if MNU_FRAME
+void frameReady(const char *frame)
+{
+  printf("FRAME");
+  if (M.getDisplayLine() != MNU_NO_CURSOR)
+    printf(" CURSOR %d,%d", M.getDisplayLine(), M.getDisplayColumn());
+  printf("\n");
+  for (uint8_t i = 0; i < frameLines; i++)
+    printf("|%s|\n", frame + (i * (FRAME_COLS + 1)));
+}
+#endif
+
+MD_Menu::value_t *valueRqst(MD_Menu::mnuId_t id, bool bGet)
+{
+  MD_Menu::value_t *pv = (useStore ? store.valueRequest(id, bGet) : nullptr);
+
+  if (pv != nullptr)    // in the persistent store
+  {
+    if (!bGet) printf("SET %d=%ld\n", id, (long)pv->value);
+    return(pv);
+  }
+
+#if MNU_ASYNC
+  if (useAsync)
+  {
+    printf("PENDING %s %d\n", (bGet ? "GET" : "SET"), id);
+    asyncId = id;
+    asyncGet = bGet;
+    return(&MD_Menu::valuePending);
+  }
+#endif
+
+  if (bGet)
+  {
+    vBuf.value = values[id];
+    vBuf.power = 0;
+  }
+  else
+  {
+    values[id] = vBuf.value;
+    printf("SET %d=%ld\n", id, (long)vBuf.value);
+  }
+
+  return(&vBuf);
+}
+
+MD_Menu::value_t *runCode(MD_Menu::mnuId_t id, bool bGet)
+{
+  if (!bGet) printf("RUN %d\n", id);
+
+  return(nullptr);    // always confirm
+}
+
+MD_Menu::listId_t virtualItems(MD_Menu::mnuId_t id, MD_Menu::virtualRequest_t req, MD_Menu::listId_t idx, char *buf, uint8_t bufLen)
+// Generated items for the profile menu (actionId 1) and device list (input 34)
+{
+  MD_Menu::listId_t count = (id == 1 ? 200 : 3);
+
+  switch (req)
+  {
+  case MD_Menu::VIRT_COUNT:  return(count);
+  case MD_Menu::VIRT_LABEL:  snprintf(buf, bufLen, (id == 1 ? "Profile %u" : "ttyUSB%u"), (unsigned)idx); break;
+  case MD_Menu::VIRT_SELECT: printf("SELECT %d:%u\n", id, (unsigned)idx); return(1);
+  }
+
+  return(0);
+}
+
+int main(int argc, char *argv[])
+{
+  static char buf[4096];
+#if MNU_PARENT_MAP
+  const char *openAt = nullptr;
+#endif
+  int opt;
+
+  M.begin();
+#if MNU_VIRTUAL_ITEMS
+  M.setVirtualCallback(virtualItems);
+#endif
+
+  while ((opt = getopt(argc, argv, "wdl:fs:t:a:b:n:o:ypir")) != -1)
+  {
+    switch (opt)
+    {
+    case 'w': M.setMenuWrap(true);            break;
+#if MNU_DISP_DIFF
+    case 'd': M.setDisplayDiff(true);         break;
+#endif
+    case 'l':
+      frameLines = atoi(optarg);
+      if (frameLines == 0 || frameLines > FRAME_LINES_MAX) frameLines = 2;
+#if MNU_MULTI_LINE
+      M.setDisplayLines(frameLines);
+#endif
+      break;
+#if MNU_FRAME
+    case 'f': M.setFrameBuffer(frame, frameLines, FRAME_COLS, frameReady); break;
+#endif
+#if MNU_STORE
+    case 's':
+      useStore = storeFileOpen(optarg);
+      if (!useStore) { perror(optarg); return(1); }
+      break;
+#endif
+    case 't': M.setTimeout(atol(optarg));     break;
+#if MNU_ACCEL
+    case 'a': M.setAcceleration(atoi(optarg)); break;
+#endif
+#if MNU_FB_RATE
+    case 'b': M.setFeedbackInterval(atoi(optarg)); break;
+#endif
+    case 'n': navDelta = atoi(optarg);       break;
+#if MNU_PARENT_MAP
+    case 'o': openAt = optarg; break;
+#endif
+#if MNU_ASYNC
+    case 'y': useAsync = true; break;
+#endif
+#if MNU_STATS
+    case 'p': printStats = true; break;
+#endif
+#if MNU_INDEX
+    case 'i': M.setIndex(idxHdr, idxItm, idxInp); break;
+    case 'r': M.setIndex(ramIndex(idxHdr, ramHdr), ramIndex(idxItm, ramItm), ramIndex(idxInp, ramInp)); break;
+#endif
+    default:
+      fprintf(stderr, "Usage: %s [-w] [-d] [-l lines] [-f] [-s file] [-t timeout] [-a interval] [-b interval] [-n delta] [-o target] [-y] [-p] [-i] [-r] [script]\n", argv[0]);
+      return(1);
+    }
+  }
+
+  if (optind < argc)
+    script = argv[optind];
+  else
+  {
+    size_t n = fread(buf, 1, sizeof(buf) - 1, stdin);
+
+    buf[n] = '\0';
+    script = buf;
+  }
+
+  // initial values
+  values[10] = 2;  values[12] = 99;  values[13] = 999; values[14] = 9999;
+  values[15] = 0x1234; values[16] = 150; values[17] = 1500; values[20] = 1234;
+  values[35] = 29;
+
+  if (useStore)
+  {
+#if MNU_STORE
+    M.setStore(&store);
+#endif
+    if (!store.begin())
+    {
+      // nothing stored yet, save the initial values
+      printf("STORE initialized\n");
+      for (uint8_t i = 0; i < ARRAY_SIZE(storeIds); i++)
+      {
+        MD_Menu::value_t v = { values[storeIds[i]], 0 };
+
+        store.setValue(storeIds[i], v);
+      }
+      store.flush();
+    }
+  }
+
+#if MNU_PARENT_MAP
+  if (openAt != nullptr)
+  {
+    MD_Menu::openTarget_t target = (*openAt == 'm' ? MD_Menu::OPEN_MENU : (*openAt == 'n' ? MD_Menu::OPEN_INPUT : MD_Menu::OPEN_ITEM));
+
+    if (!M.openMenu(atoi(openAt + 1), target))
+    {
+      fprintf(stderr, "Cannot open %s\n", openAt);
+      return(1);
+    }
+  }
+  else
+#endif
+  M.runMenu(true);
+  while (*script != '\0' && M.isInMenu())
+  {
+#if MNU_NAV_QUEUE_SIZE
+    postEvents();
+#endif
+    M.runMenu();
+  }
+
+#if MNU_STATS
+  if (printStats)
+  {
+    // only the counters, as the times and stack use depend on the host
+    const MD_Menu::stats_t &st = M.getStats();
+
+    printf("STATS lookups:%lu scanned:%lu display:%lu get:%lu set:%lu runs:%lu\n",
+           (unsigned long)st.lookups, (unsigned long)st.scanned, (unsigned long)st.display,
+           (unsigned long)st.valueGet, (unsigned long)st.valueSet, (unsigned long)st.runCount);
+  }
+#endif
+  if (useStore)
+  {
+    printf("STORE %u bytes written\n", storeFileWrites);
+    storeFileClose();
+  }
+
+  return(0);
+}
@@ -0,0 +1,49 @@
+// File storage backend for the MD_MenuStore persistent value store
+//
+// See StoreFile.h for more information
+
+#include "StoreFile.h"
+
+uint32_t storeFileWrites = 0;
+
+static FILE *fStore = nullptr;
+
+bool storeFileOpen(const char *name)
+{
+  storeFileClose();
+  fStore = fopen(name, "r+b");
+  if (fStore == nullptr)
+    fStore = fopen(name, "w+b");
+
+  return(fStore != nullptr);
+}
+
+void storeFileClose(void)
+{
+  if (fStore != nullptr)
+  {
+    fclose(fStore);
+    fStore = nullptr;
+  }
+}
+
+bool storeFileIO(bool bWrite, uint16_t addr, uint8_t *data, uint16_t len)
+{
+  if (fStore == nullptr || fseek(fStore, addr, SEEK_SET) != 0)
+    return(false);
+
+  if (bWrite)
+  {
+    storeFileWrites += len;
+    if (fwrite(data, 1, len, fStore) != len)
+      return(false);
+    return(fflush(fStore) == 0);
+  }
+  else
+  {
+    size_t n = fread(data, 1, len, fStore);
+
+    memset(data + n, 0xff, len - n);   // past the end of the file reads as erased
+    return(true);
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+// File storage backend for the MD_MenuStore persistent value store
+//
+// Emulates an EEPROM storage area in a file on the host, so the persistent
+// value store can be used and tested with the host build. Unwritten parts 
+// of the storage area read as 0xff, like erased EEPROM or flash.
+
+#include <Arduino.h>
+
+/**
+ * Open the storage file.
+ *
+ * The file is created if it does not exist.
+ *
+ * \param name the file name.
+ * \return true if the file was opened.
+ */
+bool storeFileOpen(const char *name);
+
+/**
+ * Close the storage file.
+ */
+void storeFileClose(void);
+
+/**
+ * Storage read/write callback for MD_MenuStore.
+ *
+ * Has the MD_MenuStore::cbStoreIO prototype. The number of bytes written is
+ * counted in storeFileWrites.
+ */
+bool storeFileIO(bool bWrite, uint16_t addr, uint8_t *data, uint16_t len);
+
+extern uint32_t storeFileWrites;   ///< Count of bytes written to the storage file
@@ -0,0 +1,48 @@
+// Menu tables with errors that MD_MENU_VALIDATE() must stop at compile time
+//
+// Compiled by ctest with MENU_ERROR set to select the error, and the test
+// passes if the compiler reports the matching static_assert message.
+//   1  duplicate menu item id
+//   2  menu item refers to an undefined menu
+//   3  menu tree with a cycle
+// With MENU_ERROR 0 the tables are valid and the file compiles.
+
+#include <MD_Menu.h>
+#include <MD_Menu_Compile.h>
+
+#ifndef MENU_ERROR
+#define MENU_ERROR 0
+#endif
+
+MD_Menu::value_t *valueRqst(MD_Menu::mnuId_t id, bool bGet);
+
+constexpr MD_Menu::mnuHeader_t mnuHdr[] PROGMEM =
+{
+  { 10, "Root",  10, 11, 0 },
+  { 11, "Sub",   20, 21, 0 },
+};
+
+constexpr MD_Menu::mnuItem_t mnuItm[] PROGMEM =
+{
+  { 10, "Sub",   MD_Menu::MNU_MENU,  11 },
+  { 11, "Value", MD_Menu::MNU_INPUT, 10 },
+#if MENU_ERROR == 1
+  { 11, "Again", MD_Menu::MNU_INPUT, 10 },
+#endif
+
+  { 20, "Value", MD_Menu::MNU_INPUT, 10 },
+#if MENU_ERROR == 2
+  { 21, "Lost",  MD_Menu::MNU_MENU,  12 },
+#elif MENU_ERROR == 3
+  { 21, "Root",  MD_Menu::MNU_MENU,  10 },
+#else
+  { 21, "Value", MD_Menu::MNU_INPUT, 10 },
+#endif
+};
+
+constexpr MD_Menu::mnuInput_t mnuInp[] PROGMEM =
+{
+  { 10, "Int", MD_Menu::INP_INT, valueRqst, 4, -128, 0, 127, 0, 10, nullptr, 0 },
+};
+
+MD_MENU_VALIDATE(mnuHdr, mnuItm, mnuInp);
@@ -0,0 +1,27 @@
+# Run one Menu_Host script and compare the output with the expected transcript
+#
+# Called by ctest with
+#   -DHOST=<Menu_Host executable> -DARGS=<options> -DSCRIPT=<script> -DEXPECTED=<transcript file>
+# and optionally -DCLEAN=<file> to delete the file (eg, a persistent store) before the run.
+#
+# A new or changed transcript is recorded by running Menu_Host with the same
+# options and script and saving the output to the transcript file.
+
+if(DEFINED CLEAN)
+  file(REMOVE ${CLEAN})
+endif()
+
+separate_arguments(hostArgs UNIX_COMMAND "${ARGS}")
+execute_process(COMMAND ${HOST} ${hostArgs} -- ${SCRIPT}
+                OUTPUT_VARIABLE actual
+                RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "Menu_Host failed (${result})")
+endif()
+
+file(READ ${EXPECTED} expected)
+if(NOT actual STREQUAL expected)
+  message("Expected:\n${expected}")
+  message("Actual:\n${actual}")
+  message(FATAL_ERROR "Output differs from ${EXPECTED}")
+endif()
@@ -3,29 +3,178 @@
 // See the main header file MD_Menu.h for more information
 
 #include <MD_Menu.h>
+#if MNU_STORE
+#include <MD_MenuStore.h>
+#endif
 #include <MD_Menu_lib.h>
 
 /**
  * \file
  * \brief Main code file for MD_Menu library
  */
+char MD_Menu::_lineBuf[MNU_LINE_SIZE];
+#if MNU_ASYNC
+MD_Menu::value_t MD_Menu::valuePending;
+#endif
+#if MNU_LIST_CACHE_SIZE
+uint16_t MD_Menu::_listOfs[MNU_LIST_CACHE_SIZE];
+MD_Menu::listId_t MD_Menu::_listStep = 1;
+const MD_Menu *MD_Menu::_listOwner = nullptr;
+#endif
+#if !MNU_ZERO_COPY
+MD_Menu::mnuInput_t MD_Menu::_mnuBufInput;
+MD_Menu::mnuItem_t MD_Menu::_mnuBufItem;
+#endif
+
+const MD_Menu::stateHandler_t MD_Menu::_stateTbl[ST_NONE] =
+{
+  &MD_Menu::handleMenu,     // ST_MENU
+  &MD_Menu::handleInput,    // ST_INPUT
+#if MNU_VIRTUAL_ITEMS
+  &MD_Menu::handleVirtual,  // ST_VIRTUAL
+#endif
+};
+
+#if MNU_DEF_LOCAL
 MD_Menu::MD_Menu(cbUserNav cbNav, cbUserDisplay cbDisp,
                 const mnuHeader_t *mnuHdr, mnuId_t mnuHdrCount,
                 const mnuItem_t *mnuItm, mnuId_t mnuItmCount,
                 const mnuInput_t *mnuInp, mnuId_t mnuInpCount) :
-                _mnuHdr(mnuHdr), _mnuHdrCount(mnuHdrCount),
-                _mnuItm(mnuItm), _mnuItmCount(mnuItmCount),
-                _mnuInp(mnuInp), _mnuInpCount(mnuInpCount),
-                _timeout(0), _options(0)
+                MD_Menu(cbNav, cbDisp, _defLocal)
+{
+  _defLocal.mnuHdr = mnuHdr;
+  _defLocal.mnuHdrCount = mnuHdrCount;
+  _defLocal.mnuItm = mnuItm;
+  _defLocal.mnuItmCount = mnuItmCount;
+  _defLocal.mnuInp = mnuInp;
+  _defLocal.mnuInpCount = mnuInpCount;
+#if MNU_INDEX
+  _defLocal.idxHdr.pos = _defLocal.idxItm.pos = _defLocal.idxInp.pos = nullptr;
+  _defLocal.idxHdr.inProgmem = _defLocal.idxItm.inProgmem = _defLocal.idxInp.inProgmem = false;
+  _defLocal.idxHdr.allocated = _defLocal.idxItm.allocated = _defLocal.idxInp.allocated = false;
+#endif
+#if MNU_SEARCH
+  _defLocal.srchItm = nullptr;
+#endif
+#if MNU_PARENT_MAP
+  _defLocal.parentMap = nullptr;
+#endif
+}
+#endif
+
+MD_Menu::MD_Menu(cbUserNav cbNav, cbUserDisplay cbDisp, mnuDef_t &def) :
+                _cbNav(nullptr), _def(&def),
+                _timeout(0), _options(0), _stateNext(ST_NONE)
 {
+#if MNU_STORE
+  _store = nullptr;
+#endif
+#if MNU_NAV_QUEUE_SIZE
+  _navQHead = _navQTail = 0;
+#endif
+#if MNU_DISP_DIFF
+  _dispValid[0] = _dispValid[1] = false;
+#endif
+#if MNU_SEARCH
+  _srchLen = 0;
+#endif
+#if MNU_ASYNC
+  _asyncId = -1;
+  _asyncDone = false;
+#endif
+#if MNU_VIRTUAL_ITEMS
+  _cbVirt = nullptr;
+#endif
+#if MNU_FB_RATE
+  _fbInterval = 0;
+  _timeFeedback = 0;
+#endif
+#if MNU_FRAME
+  _frame = nullptr;
+  _frameCurLine = MNU_NO_CURSOR;
+#endif
+#if MNU_MULTI_LINE
+  _dispLines = 2;
+  _viewTop = _viewPrev = -1;
+#endif
+#if MNU_DIGIT_EDIT
+  _digitPos = 0;
+#endif
+#if MNU_ACCEL
+  setAcceleration(0);
+  _accelNav = NAV_NULL;
+  _accelMult = 1;
+#endif
+#if MNU_STATS
+  resetStats();
+  _stackBase = 0;
+#endif
   setUserNavCallback(cbNav);
   setUserDisplayCallback(cbDisp);
 }
 
+MD_Menu::~MD_Menu(void)
+{
+  listCacheClear();
+#if MNU_DEF_LOCAL
+  // a shared definition and its indices are kept for the other objects
+  if (_def == &_defLocal)
+  {
+#if MNU_INDEX
+    freeIndex(_defLocal.idxHdr);
+    freeIndex(_defLocal.idxItm);
+    freeIndex(_defLocal.idxInp);
+#endif
+#if MNU_SEARCH
+    if (_defLocal.srchItm != nullptr) free((void *)_defLocal.srchItm);
+#endif
+#if MNU_PARENT_MAP
+    if (_defLocal.parentMap != nullptr) free((void *)_defLocal.parentMap);
+#endif
+  }
+#endif
+}
+
+void MD_Menu::begin(void)
+{
+#if MNU_INDEX
+  // build only those indices not already supplied by setIndex()
+  if (_def->idxHdr.pos == nullptr) buildIndex(_def->idxHdr, _def->mnuHdr, _def->mnuHdrCount, sizeof(mnuHeader_t));
+  if (_def->idxItm.pos == nullptr) buildIndex(_def->idxItm, _def->mnuItm, _def->mnuItmCount, sizeof(mnuItem_t));
+  if (_def->idxInp.pos == nullptr) buildIndex(_def->idxInp, _def->mnuInp, _def->mnuInpCount, sizeof(mnuInput_t));
+#endif
+#if MNU_SEARCH
+  if (_def->srchItm == nullptr) buildSearch();
+#endif
+#if MNU_PARENT_MAP
+  if (_def->parentMap == nullptr) buildParentMap();
+#endif
+}
+
+#if MNU_INDEX
+void MD_Menu::setIndex(const mnuIndex_t &idxHdr, const mnuIndex_t &idxItm, const mnuIndex_t &idxInp)
+{
+  freeIndex(_def->idxHdr);
+  freeIndex(_def->idxItm);
+  freeIndex(_def->idxInp);
+
+  // supplied tables belong to the caller
+  _def->idxHdr = idxHdr;
+  _def->idxItm = idxItm;
+  _def->idxInp = idxInp;
+  _def->idxHdr.allocated = _def->idxItm.allocated = _def->idxInp.allocated = false;
+}
+#endif
+
 void MD_Menu::reset(void)
 { 
   CLEAR_FLAG(F_INMENU); 
   CLEAR_FLAG(F_INEDIT); 
+  CLEAR_FLAG(F_INVIRT);
+#if MNU_ASYNC
+  asyncCancel();
+#endif
+  listCacheClear();
   _currMenu = 0; 
 };
 
@@ -41,12 +190,408 @@ void MD_Menu::setUserDisplayCallback(cbUserDisplay cbDisp)
     _cbDisp = cbDisp; 
 };
 
+#if MNU_VIRTUAL_ITEMS
+void MD_Menu::setVirtualCallback(cbVirtual cbVirt)
+{
+  _cbVirt = cbVirt;
+};
+#endif
+
+#if MNU_NAV_QUEUE_SIZE
+bool MD_Menu::postNav(userNavAction_t nav, uint16_t incDelta)
+// Only the producer changes the head and the slot is written before the 
+// head is moved, so the consumer never sees a partially written event.
+{
+  uint8_t next = (_navQHead + 1) % MNU_NAV_QUEUE_SIZE;
+
+  if (next == _navQTail)    // full
+    return(false);
+
+  _navQAction[_navQHead] = nav;
+  _navQDelta[_navQHead] = incDelta;
+  _navQHead = next;
+
+  return(true);
+}
+#endif
+
+MD_Menu::userNavAction_t MD_Menu::getNav(uint16_t &incDelta)
+// Get the next navigation action. Queued events are processed first,
+// with consecutive INC or DEC events combined into one action by 
+// adding up their increments. _navRepeat counts the events combined
+// for actions that step one item at a time.
+{
+  STATS_STACK();
+  _navRepeat = 1;
+
+#if MNU_NAV_QUEUE_SIZE
+  if (_navQHead != _navQTail)
+  {
+    userNavAction_t nav = (userNavAction_t)_navQAction[_navQTail];
+
+    incDelta = _navQDelta[_navQTail];
+    _navQTail = (_navQTail + 1) % MNU_NAV_QUEUE_SIZE;
+
+    if (nav == NAV_INC || nav == NAV_DEC)
+    {
+      while (_navQHead != _navQTail && _navQAction[_navQTail] == nav)
+      {
+        uint16_t d = _navQDelta[_navQTail];
+
+        incDelta = (incDelta > 0xffff - d ? 0xffff : incDelta + d);
+        _navRepeat++;
+        _navQTail = (_navQTail + 1) % MNU_NAV_QUEUE_SIZE;
+      }
+    }
+
+    return(nav);
+  }
+#endif
+
+  return(_cbNav != nullptr ? _cbNav(incDelta) : NAV_NULL);
+}
+
 // Status and options
 bool MD_Menu::isInMenu(void) { return(TEST_FLAG(F_INMENU)); };
 bool MD_Menu::isInEdit(void) { return(TEST_FLAG(F_INEDIT)); };
 void MD_Menu::setMenuWrap(bool bSet)  { if (bSet) { SET_FLAG(F_MENUWRAP); } else { CLEAR_FLAG(F_MENUWRAP); } };
 void MD_Menu::setAutoStart(bool bSet) { if (bSet) { SET_FLAG(F_AUTOSTART); } else { CLEAR_FLAG(F_AUTOSTART); } };
 void MD_Menu::setTimeout(uint32_t t) { _timeout = t; };
+#if MNU_FB_RATE
+void MD_Menu::setFeedbackInterval(uint16_t interval) { _fbInterval = interval; };
+#endif
+#if MNU_ACCEL
+void MD_Menu::setAcceleration(uint16_t interval, uint8_t count) { _accelInterval = interval; _accelCount = (count == 0 ? 1 : count); };
+#endif
+#if MNU_FRAME
+void MD_Menu::setFrameBuffer(char *frame, uint8_t lines, uint8_t cols, cbFrameReady cbFrame)
+{
+  _frame = (cbFrame != nullptr && lines != 0 ? frame : nullptr);
+  _frameLines = lines;
+  _frameCols = cols;
+  _cbFrame = cbFrame;
+  CLEAR_FLAG(F_FRAMEDIRTY);
+  if (_frame != nullptr) frameUpdate(DISP_CLEAR, nullptr);
+}
+#endif
+
+#if MNU_MULTI_LINE
+void MD_Menu::setDisplayLines(uint8_t lines) { _dispLines = (lines == 0 ? 1 : lines); };
+#endif
+#if MNU_DISP_DIFF
+void MD_Menu::setDisplayDiff(bool bSet) { if (bSet) { SET_FLAG(F_DISPDIFF); } else { CLEAR_FLAG(F_DISPDIFF); } };
+#endif
+
+bool MD_Menu::display(userDisplayAction_t action, char *msg)
+// All display requests are funneled through here so that the 
+// display diffing can be applied when it is enabled.
+{
+  STATS_STACK();
+#if MNU_FRAME
+  if (_frame != nullptr)
+  {
+    frameUpdate(action, msg);
+    return(true);
+  }
+#endif
+
+#if MNU_DISP_DIFF
+  if (TEST_FLAG(F_DISPDIFF))
+  {
+    switch (action)
+    {
+    case DISP_CLEAR:
+      // While the menu is running the display is changed through line 
+      // differences, so only a clear at menu start and end goes through.
+      // Lines past the second are not diffed, so need the clear.
+#if MNU_MULTI_LINE
+      if (TEST_FLAG(F_INMENU) && _dispLines <= 2) return(true);
+#else
+      if (TEST_FLAG(F_INMENU)) return(true);
+#endif
+      _dispShadow[0][0] = _dispShadow[1][0] = '\0';
+      _dispValid[0] = _dispValid[1] = true;
+      break;
+
+    case DISP_L0:
+    case DISP_L1:
+      {
+        uint8_t line = (action == DISP_L0 ? 0 : 1);
+        char *shadow = _dispShadow[line];
+        size_t lenNew = strlen(msg);
+        uint8_t lenOld, lenMax, first, last;
+
+        if (!_dispValid[line] || lenNew > MNU_DISP_WIDTH)
+        {
+          // display is unknown or line too long, send it all
+          _dispValid[line] = (lenNew <= MNU_DISP_WIDTH);
+          if (_dispValid[line]) strcpy(shadow, msg);
+          break;
+        }
+
+        // Find the span of columns that are different. Columns past 
+        // the end of the shorter string are treated as spaces.
+        lenOld = strlen(shadow);
+        lenMax = (lenNew > lenOld ? lenNew : lenOld);
+        for (first = 0; first < lenMax; first++)
+          if ((first < lenNew ? msg[first] : ' ') != (first < lenOld ? shadow[first] : ' '))
+            break;
+
+        if (first == lenMax)    // nothing changed
+          return(true);
+
+        for (last = lenMax - 1; last > first; last--)
+          if ((last < lenNew ? msg[last] : ' ') != (last < lenOld ? shadow[last] : ' '))
+            break;
+
+        // build the span and send it
+        {
+          char sz[MNU_DISP_WIDTH + 1];
+          uint8_t n = 0;
+
+          for (uint8_t i = first; i <= last; i++)
+            sz[n++] = (i < lenNew ? msg[i] : ' ');
+          sz[n] = '\0';
+
+          strcpy(shadow, msg);
+          _dispLine = line;
+          _dispCol = first;
+          STATS_INC(display);
+          return(_cbDisp(DISP_SPAN, sz));
+        }
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+#endif
+
+  STATS_INC(display);
+  return(_cbDisp(action, msg));
+}
+
+#if MNU_FRAME
+void MD_Menu::frameUpdate(userDisplayAction_t action, char *msg)
+// Compose the display request into the frame buffer. Writing a 
+// line removes the edit cursor, as it would on a character display.
+{
+  int16_t line;
+
+  switch (action)
+  {
+  case DISP_CLEAR:
+    for (uint8_t i = 0; i < _frameLines; i++)
+    {
+      char *p = _frame + (i * (_frameCols + 1));
+
+      memset(p, ' ', _frameCols);
+      p[_frameCols] = '\0';
+    }
+    _frameCurLine = MNU_NO_CURSOR;
+    SET_FLAG(F_FRAMEDIRTY);
+    return;
+
+  case DISP_CURSOR:
+    _frameCurLine = _dispLine;
+    _frameCurCol = _dispCol;
+    SET_FLAG(F_FRAMEDIRTY);
+    return;
+
+  case DISP_L0:   line = 0;         break;
+  case DISP_L1:   line = 1;         break;
+  case DISP_LINE: line = _dispLine; break;
+
+  default:  return;   // nothing else changes the frame
+  }
+
+  if (_frameLines == 1) line--;   // a one line frame only shows line 1
+
+  if (line >= 0 && line < _frameLines)
+  {
+    char *p = _frame + (line * (_frameCols + 1));
+    uint8_t i = 0;
+
+    while (i < _frameCols && *msg != '\0')
+      p[i++] = *msg++;
+    while (i < _frameCols)
+      p[i++] = ' ';
+
+    _frameCurLine = MNU_NO_CURSOR;
+    SET_FLAG(F_FRAMEDIRTY);
+  }
+}
+
+void MD_Menu::frameFlush(void)
+{
+  STATS_STACK();
+  if (_frame == nullptr || !TEST_FLAG(F_FRAMEDIRTY))
+    return;
+
+  // the cursor position is passed as for a DISP_CURSOR request
+  _dispLine = _frameCurLine;
+  _dispCol = _frameCurCol;
+  CLEAR_FLAG(F_FRAMEDIRTY);
+  STATS_INC(display);
+  _cbFrame(_frame);
+}
+#endif
+
+MD_Menu::value_t *MD_Menu::valueRequest(const mnuInput_t *mInp, bool bGet)
+// All value requests are funneled through here so they can be counted, 
+// and so that requests completed later by completeValueRequest() are 
+// handled in one place. A request being waited for returns nullptr with 
+// the F_ASYNCWAIT flag set. A 'get' for an input with a completed 
+// request returns the value supplied on completion.
+{
+  value_t *pv;
+
+  STATS_STACK();
+#if MNU_STATS
+  if (bGet) { STATS_INC(valueGet); } else { STATS_INC(valueSet); }
+#endif
+
+#if MNU_ASYNC
+  if (bGet && _asyncDone && _asyncId == mInp->id)
+    pv = _asyncValue;
+  else
+  {
+    _asyncId = mInp->id;
+    _asyncDone = false;
+    pv = mInp->cbVR(mInp->id, bGet);
+    if (pv == &valuePending)
+    {
+      SET_FLAG(F_ASYNCWAIT);
+      if (bGet) { CLEAR_FLAG(F_ASYNCSET); } else { SET_FLAG(F_ASYNCSET); }
+      return(nullptr);
+    }
+  }
+
+  _asyncId = -1;
+  _asyncDone = false;
+#else
+  pv = mInp->cbVR(mInp->id, bGet);
+#endif
+
+  return(pv);
+}
+
+#if MNU_ASYNC
+bool MD_Menu::completeValueRequest(mnuId_t id, value_t *pValue)
+{
+  if (id == -1 || id != _asyncId)
+    return(false);
+
+  _asyncValue = pValue;
+  _asyncDone = true;
+
+  return(true);
+}
+
+void MD_Menu::asyncCancel(void)
+{
+  CLEAR_FLAG(F_ASYNCWAIT);
+  _asyncId = -1;
+  _asyncDone = false;
+}
+
+void MD_Menu::asyncShow(const mnuInput_t *mInp)
+{
+  char *p = strPreamble(_lineBuf, mInp);
+
+  p = strAppend(p, INP_PENDING);
+  strPostamble(p);
+  display(DISP_L1, _lineBuf);
+}
+#endif
+
+void MD_Menu::feedback(const mnuInput_t *mInp)
+// Real time feedback of the value being edited. The value is always 
+// updated, but if the feedback interval is set the set request is held 
+// back until the interval has passed since the last one. The latest 
+// value is then sent by handleInput().
+{
+  _pValue->value = _V.value;
+
+#if MNU_FB_RATE
+  if (_fbInterval != 0 && millis() - _timeFeedback < _fbInterval)
+  {
+    SET_FLAG(F_FBPENDING);
+  }
+  else
+#endif
+    feedbackSend(mInp);
+}
+
+void MD_Menu::feedbackSend(const mnuInput_t *mInp)
+{
+#if MNU_FB_RATE
+  CLEAR_FLAG(F_FBPENDING);
+  _timeFeedback = millis();
+#endif
+  valueRequest(mInp, false);
+#if MNU_ASYNC
+  asyncCancel();    // feedback is not waited for
+#endif
+}
+
+#if MNU_STATS
+void MD_Menu::resetStats(void)
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void MD_Menu::dumpStats(Print &out)
+{
+  out.print(F("lookups:"));   out.print(_stats.lookups);
+  out.print(F(" scanned:"));  out.print(_stats.scanned);
+  out.print(F(" display:"));  out.print(_stats.display);
+  out.print(F(" get:"));      out.print(_stats.valueGet);
+  out.print(F(" set:"));      out.print(_stats.valueSet);
+  out.print(F(" runs:"));     out.print(_stats.runCount);
+  out.print(F(" max us:"));   out.print(_stats.runMaxTime);
+  out.print(F(" stack:"));    out.println(_stats.stackMax);
+}
+
+void MD_Menu::stackCheck(void)
+{
+  uint8_t mark;
+  uintptr_t used;
+
+  if (_stackBase == 0) return;
+
+  used = _stackBase - (uintptr_t)&mark;
+  if (used > _stats.stackMax) _stats.stackMax = (used > 0xffff ? 0xffff : used);
+}
+#endif
+
+#if MNU_ACCEL
+uint16_t MD_Menu::accelerate(userNavAction_t nav, uint16_t incDelta)
+// Work out the increment multiplier from the run of fast INC or DEC events 
+// in the same direction. This must be called before timerStart() as the 
+// time since the last key is used to decide if the event is fast.
+{
+  uint8_t step;
+  uint32_t inc;
+
+  if (nav != NAV_INC && nav != NAV_DEC)
+    return(incDelta);
+
+  if (_accelInterval == 0 || nav != _accelNav || millis() - _timeLastKey > _accelInterval)
+    _accelRun = 0;
+  else
+    _accelRun = (_accelRun + _navRepeat > 0xff ? 0xff : _accelRun + _navRepeat);
+  _accelNav = nav;
+
+  step = _accelRun / _accelCount;
+  if (step >= ARRAY_SIZE(ACCEL_MULT)) step = ARRAY_SIZE(ACCEL_MULT) - 1;
+  _accelMult = ACCEL_MULT[step];
+
+  inc = (uint32_t)incDelta * _accelMult;
+  return(inc > 0xffff ? 0xffff : inc);
+}
+#endif
 
 void MD_Menu::timerStart(void)
 {
@@ -60,22 +605,512 @@ void MD_Menu::timerCheck(void)
   if (millis() - _timeLastKey >= _timeout)
   {
     MD_PRINTS("\ntimerCheck: Menu timeout");
+#if MNU_FB_RATE
+    if (TEST_FLAG(F_FBPENDING))   // send the last value held back
+      feedbackSend(loadInput(loadItem(_mnuStack[_currMenu].idItmCurr)->actionId));
+#endif
     reset();
   }
 }
 
+#if MNU_INDEX
+void MD_Menu::buildIndex(mnuIndex_t &idx, const void *tbl, mnuId_t count, size_t recSize)
+// Build a dense lookup table of record positions for a PROGMEM table.
+// All the record types have the id as the first field, so only that 
+// part of each record needs to be read.
+{
+  const uint8_t *p = (const uint8_t *)tbl;
+  mnuId_t *pos;
+  mnuId_t id, idMax;
+  int32_t range;
+
+  freeIndex(idx);
+  idx.inProgmem = false;
+  if (count <= 0) return;
+
+  // work out the range of ids in use
+  memcpy_P(&idx.idMin, p, sizeof(mnuId_t));
+  idMax = idx.idMin;
+  for (mnuId_t i = 1; i < count; i++)
+  {
+    memcpy_P(&id, p + (i * recSize), sizeof(mnuId_t));
+    if (id < idx.idMin) idx.idMin = id;
+    if (id > idMax) idMax = id;
+  }
+
+  // allocate and fill the table, unless the ids are too sparse for a dense index
+  range = (int32_t)idMax - idx.idMin + 1;
+  if (range > MNU_INDEX_MAX)
+  {
+    MD_PRINTS("\nbuildIndex: id range too large, using table scan");
+    return;
+  }
+  idx.size = range;
+  pos = (mnuId_t *)malloc(idx.size * sizeof(mnuId_t));
+  if (pos == nullptr)
+  {
+    MD_PRINTS("\nbuildIndex: no memory, using table scan");
+    return;
+  }
+
+  memset(pos, -1, idx.size * sizeof(mnuId_t));
+  for (mnuId_t i = count - 1; i >= 0; i--)   // backwards so the first duplicate wins, same as a scan
+  {
+    memcpy_P(&id, p + (i * recSize), sizeof(mnuId_t));
+    pos[id - idx.idMin] = i;
+  }
+  idx.pos = pos;
+  idx.allocated = true;
+}
+
+void MD_Menu::freeIndex(mnuIndex_t &idx)
+// Release the index table only if it was built by buildIndex()
+{
+  if (idx.pos != nullptr && idx.allocated)
+    free((void *)idx.pos);
+  idx.pos = nullptr;
+  idx.allocated = false;
+}
+
+MD_Menu::mnuId_t MD_Menu::lookupIndex(const mnuIndex_t &idx, mnuId_t id)
+{
+  mnuId_t pos;
+
+  if (id < idx.idMin || id - idx.idMin >= idx.size)
+    return(-1);
+
+  if (idx.inProgmem)
+    memcpy_P(&pos, &idx.pos[id - idx.idMin], sizeof(mnuId_t));
+  else
+    pos = idx.pos[id - idx.idMin];
+
+  return(pos);
+}
+#endif
+
+#if MNU_SEARCH
+int MD_Menu::searchCompare(const char *s, mnuId_t pos, uint8_t len)
+{
+  return(strncasecmp_P(s, _def->mnuItm[pos].label, len));
+}
+
+MD_Menu::mnuId_t MD_Menu::searchId(mnuId_t k)
+{
+  mnuId_t id;
+
+  memcpy_P(&id, &_def->mnuItm[_def->srchItm[k]].id, sizeof(mnuId_t));
+  return(id);
+}
+
+bool MD_Menu::searchLess(mnuId_t a, mnuId_t b)
+// true if the item at table position a sorts before the item at b, 
+// by label and then by id
+{
+  char label[ITEM_LABEL_SIZE + 1];
+  mnuId_t idA, idB;
+  int cmp;
+
+  memcpy_P(label, _def->mnuItm[a].label, sizeof(label));
+  cmp = searchCompare(label, b, sizeof(label));
+  if (cmp != 0) return(cmp < 0);
+
+  memcpy_P(&idA, &_def->mnuItm[a].id, sizeof(mnuId_t));
+  memcpy_P(&idB, &_def->mnuItm[b].id, sizeof(mnuId_t));
+  return(idA < idB);
+}
+
+void MD_Menu::searchSift(mnuId_t *srch, mnuId_t root, mnuId_t count)
+// Move srch[root] down the heap of count entries to its place
+{
+  for (;;)
+  {
+    int32_t child = 2 * (int32_t)root + 1;   // can be past the end of mnuId_t
+    mnuId_t t;
+
+    if (child >= count) break;
+    if (child + 1 < count && searchLess(srch[child], srch[child + 1])) child++;
+    if (!searchLess(srch[root], srch[child])) break;
+
+    t = srch[root];
+    srch[root] = srch[child];
+    srch[child] = t;
+    root = child;
+  }
+}
+
+void MD_Menu::buildSearch(void)
+// Sort the item table positions by label, and items with the same label
+// by id, so that searchFind() can binary search each label for the items 
+// in the current menu. A heap sort is O(n log n) and needs no extra memory
+// or recursion.
+{
+  mnuId_t *srch;
+  mnuId_t n = _def->mnuItmCount;
+
+  if (n <= 0) return;
+
+  srch = (mnuId_t *)malloc(n * sizeof(mnuId_t));
+  if (srch == nullptr)
+  {
+    MD_PRINTS("\nbuildSearch: no memory, using menu scan");
+    return;
+  }
+
+  for (mnuId_t i = 0; i < n; i++)
+    srch[i] = i;
+  for (mnuId_t i = n / 2; i > 0; i--)
+    searchSift(srch, i - 1, n);
+  for (mnuId_t i = n - 1; i > 0; i--)
+  {
+    mnuId_t t = srch[0];
+
+    srch[0] = srch[i];
+    srch[i] = t;
+    searchSift(srch, 0, i);
+  }
+  _def->srchItm = srch;
+}
+
+MD_Menu::mnuId_t MD_Menu::searchFind(void)
+// The sorted index is binary searched for the first label not before the
+// search string. The labels that start with the search string follow, 
+// each label in id order, so each is binary searched for its first id in 
+// the current menu. The lowest of these is the first item in menu order, 
+// as for the scan without the index.
+{
+  mnuId_t idStart = stackItmStart();
+  mnuId_t idEnd = stackItmEnd();
+  mnuId_t id;
+
+  if (_def->srchItm == nullptr)
+  {
+    // no index, so scan the items in the current menu.
+    // The end is tested after the body so the loop ends if idEnd is the largest id.
+    if (idStart > idEnd) return(-1);
+    for (id = idStart; ; id++)
+    {
+      const mnuItem_t *mi = loadItem(id);
+
+      if (mi != nullptr && strncasecmp(_srch, mi->label, _srchLen) == 0)
+        return(id);
+      if (id == idEnd) break;
+    }
+    return(-1);
+  }
+
+  mnuId_t n = _def->mnuItmCount;
+  mnuId_t lo = 0, hi = n;
+  mnuId_t idFound = -1;
+
+  while (lo < hi)
+  {
+    mnuId_t mid = lo + (hi - lo) / 2;
+
+    if (searchCompare(_srch, _def->srchItm[mid], _srchLen) > 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  while (lo < n && idFound != idStart && searchCompare(_srch, _def->srchItm[lo], _srchLen) == 0)
+  {
+    char label[ITEM_LABEL_SIZE + 1];
+    mnuId_t end = n;
+
+    // find the end of the entries with this label ...
+    memcpy_P(label, _def->mnuItm[_def->srchItm[lo]].label, sizeof(label));
+    for (mnuId_t first = lo + 1; first < end; )
+    {
+      mnuId_t mid = first + (end - first) / 2;
+
+      if (searchCompare(label, _def->srchItm[mid], sizeof(label)) < 0)
+        end = mid;
+      else
+        first = mid + 1;
+    }
+
+    // ... and the first of them with an id in the current menu
+    hi = end;
+    while (lo < hi)
+    {
+      mnuId_t mid = lo + (hi - lo) / 2;
+
+      if (searchId(mid) < idStart)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if (lo < end)
+    {
+      id = searchId(lo);
+      if (id <= idEnd && (idFound == -1 || id < idFound))
+        idFound = id;
+    }
+    lo = end;
+  }
+
+  return(idFound);
+}
+
+bool MD_Menu::searchItem(char c)
+{
+  mnuId_t id;
+
+  if (!TEST_FLAG(F_INMENU) || TEST_FLAG(F_INEDIT) || TEST_FLAG(F_INVIRT))
+    return(false);
+
+  switch (c)
+  {
+  case '\0':   // clear the search
+    _srchLen = 0;
+    return(true);
+
+  case '\b':   // remove the last character
+    if (_srchLen > 0) _srchLen--;
+    if (_srchLen == 0) return(true);
+    break;
+
+  default:
+    if (_srchLen >= ITEM_LABEL_SIZE) return(false);
+    _srch[_srchLen++] = c;
+    break;
+  }
+  _srch[_srchLen] = '\0';
+
+  id = searchFind();
+  if (id == -1)
+  {
+    MD_PRINTS("\nsearchItem: no match");
+    if (c != '\b') _srch[--_srchLen] = '\0';   // ignore the character
+    return(false);
+  }
+
+  timerStart();
+  if (id != _mnuStack[_currMenu].idItmCurr)
+  {
+    _mnuStack[_currMenu].idItmCurr = id;
+    menuUpdate(false);
+  }
+
+  return(true);
+}
+#endif
+
+#if MNU_PARENT_MAP
+MD_Menu::mnuId_t MD_Menu::tablePos(const void *tbl, mnuId_t count, size_t recSize, mnuId_t id)
+// All the record types have the id as the first field, so only that 
+// part of each record needs to be read.
+{
+  const uint8_t *p = (const uint8_t *)tbl;
+
+  for (mnuId_t i = 0; i < count; i++)
+  {
+    mnuId_t idRec;
+
+    memcpy_P(&idRec, p + (i * recSize), sizeof(mnuId_t));
+    if (idRec == id)
+      return(i);
+  }
+
+  return(-1);
+}
+
+MD_Menu::mnuId_t MD_Menu::recordPos(openTarget_t tbl, mnuId_t id)
+// Find the record in the header (OPEN_MENU), item (OPEN_ITEM) or input 
+// (OPEN_INPUT) table, using the id lookup index if there is one.
+{
+  switch (tbl)
+  {
+  case OPEN_MENU:
+#if MNU_INDEX
+    if (_def->idxHdr.pos != nullptr) return(lookupIndex(_def->idxHdr, id));
+#endif
+    return(tablePos(_def->mnuHdr, _def->mnuHdrCount, sizeof(mnuHeader_t), id));
+
+  case OPEN_ITEM:
+#if MNU_INDEX
+    if (_def->idxItm.pos != nullptr) return(lookupIndex(_def->idxItm, id));
+#endif
+    return(tablePos(_def->mnuItm, _def->mnuItmCount, sizeof(mnuItem_t), id));
+
+  case OPEN_INPUT:
+#if MNU_INDEX
+    if (_def->idxInp.pos != nullptr) return(lookupIndex(_def->idxInp, id));
+#endif
+    return(tablePos(_def->mnuInp, _def->mnuInpCount, sizeof(mnuInput_t), id));
+  }
+
+  return(-1);
+}
+
+void MD_Menu::buildParentMap(void)
+// The map is one allocation holding, in order
+// - for each header, the position of the parent header (-1 for the root or if not linked)
+// - for each header, the id of the item in the parent header that opens it
+// - for each item, the position of the first header with the item in its range (-1 if none)
+// - for each input, the id of the first item that edits it (-1 if none)
+// This scans the tables, but is only done once.
+{
+  mnuId_t nHdr = _def->mnuHdrCount;
+  mnuId_t nItm = _def->mnuItmCount;
+  mnuId_t nInp = _def->mnuInpCount;
+  size_t size = ((2 * nHdr) + nItm + nInp) * sizeof(mnuId_t);
+  mnuId_t *hdrParent, *hdrItm, *itmHdr, *inpItm;
+  mnuItem_t mi;
+
+  if (nHdr <= 0) return;
+
+  hdrParent = (mnuId_t *)malloc(size);
+  if (hdrParent == nullptr)
+  {
+    MD_PRINTS("\nbuildParentMap: no memory");
+    return;
+  }
+  memset(hdrParent, -1, size);
+  hdrItm = hdrParent + nHdr;
+  itmHdr = hdrItm + nHdr;
+  inpItm = itmHdr + nItm;
+
+  for (mnuId_t i = 0; i < nItm; i++)
+  {
+    memcpy_P(&mi, &_def->mnuItm[i], sizeof(mnuItem_t));
+
+    // find the menu that includes the item
+    for (mnuId_t h = 0; h < nHdr && itmHdr[i] == -1; h++)
+    {
+      mnuId_t idStart, idEnd;
+
+      MNU_READ_ID(idStart, _def->mnuHdr[h].idItmStart);
+      MNU_READ_ID(idEnd, _def->mnuHdr[h].idItmEnd);
+      if (mi.id >= idStart && mi.id <= idEnd)
+        itmHdr[i] = h;
+    }
+    if (itmHdr[i] == -1) continue;   // not in any menu
+
+    // link the menu or input it leads to back to the item
+    if (mi.action == MNU_MENU)
+    {
+      mnuId_t h = recordPos(OPEN_MENU, mi.actionId);
+
+      if (h > 0 && hdrParent[h] == -1)  // the root never has a parent
+      {
+        hdrParent[h] = itmHdr[i];
+        hdrItm[h] = mi.id;
+      }
+    }
+    else if (mi.action == MNU_INPUT || mi.action == MNU_INPUT_FB)
+    {
+      mnuId_t n = recordPos(OPEN_INPUT, mi.actionId);
+
+      if (n != -1 && inpItm[n] == -1)
+        inpItm[n] = mi.id;
+    }
+  }
+
+  _def->parentMap = hdrParent;
+}
+
+bool MD_Menu::openMenu(mnuId_t id, openTarget_t target)
+{
+  const mnuId_t *hdrParent = _def->parentMap;
+  const mnuId_t *hdrItm = hdrParent + _def->mnuHdrCount;
+  const mnuId_t *itmHdr = hdrItm + _def->mnuHdrCount;
+  const mnuId_t *inpItm = itmHdr + _def->mnuItmCount;
+  mnuId_t trail[MNU_STACK_SIZE];  // header positions from the target back to the root
+  mnuId_t idItm = -1;   // current item in the target menu, -1 for the menu default
+  mnuId_t h;
+  uint8_t depth = 0;
+
+  if (hdrParent == nullptr) return(false);
+
+  // find the menu header for the target
+  if (target == OPEN_INPUT)
+  {
+    h = recordPos(OPEN_INPUT, id);
+    if (h == -1 || inpItm[h] == -1) return(false);
+    id = inpItm[h];
+  }
+
+  if (target == OPEN_MENU)
+    h = recordPos(OPEN_MENU, id);
+  else
+  {
+    h = recordPos(OPEN_ITEM, id);
+    if (h != -1) h = itmHdr[h];
+    idItm = id;
+  }
+  if (h == -1) return(false);
+
+  // follow the parents back to the root
+  trail[depth++] = h;
+  while (h != 0)
+  {
+    h = hdrParent[h];
+    if (h == -1 || depth >= MNU_STACK_SIZE)
+    {
+      MD_PRINTS("\nopenMenu: not reachable");
+      return(false);
+    }
+    trail[depth++] = h;
+  }
+
+  // rebuild the menu stack from the root down
+  MD_PRINT("\nopenMenu: depth ", depth);
+  reset();
+  for (_currMenu = 0; _currMenu < depth; _currMenu++)
+  {
+    stackLoad(trail[depth - 1 - _currMenu]);
+    if (_currMenu < depth - 1)
+      _mnuStack[_currMenu].idItmCurr = hdrItm[trail[depth - 2 - _currMenu]];
+  }
+  _currMenu = depth - 1;
+  if (idItm != -1) _mnuStack[_currMenu].idItmCurr = idItm;
+
+  // The menu is only marked as running after the state is entered, 
+  // as for handleMenu(), so that display diffing lets the clear through.
+  _stateNext = (target == OPEN_INPUT ? ST_INPUT : ST_MENU);
+  stateEnter();
+  SET_FLAG(F_INMENU);
+
+#if MNU_FRAME
+  frameFlush();
+#endif
+
+  return(true);
+}
+#endif
+
 void MD_Menu::loadMenu(mnuId_t id)
 // Load a menu header definition to the current stack position
 {
   mnuId_t idx = 0;
+#if !MNU_ZERO_COPY
   mnuHeader_t mh;
+#endif
+
+  STATS_INC(lookups);
+
+#if MNU_INDEX
+  if (id != -1 && _def->idxHdr.pos != nullptr)
+  {
+    idx = lookupIndex(_def->idxHdr, id);
+    if (idx == -1) idx = 0;   // not found, so load the first one by default
+    id = -1;                  // skip the search
+  }
+#endif
 
   if (id != -1)   // look for a menu with that id and load it up
   {
-    for (mnuId_t i = 0; i < _mnuHdrCount; i++)
+    for (mnuId_t i = 0; i < _def->mnuHdrCount; i++)
     {
-      memcpy_P(&mh, &_mnuHdr[i], sizeof(mnuHeader_t));
+#if MNU_ZERO_COPY
+      STATS_INC(scanned);
+      if (_def->mnuHdr[i].id == id)
+#else
+      memcpy_P(&mh, &_def->mnuHdr[i], sizeof(mnuHeader_t));
+      STATS_INC(scanned);
       if (mh.id == id)
+#endif
       {
         idx = i;  // found it!
         break;
@@ -84,30 +1119,116 @@ void MD_Menu::loadMenu(mnuId_t id)
   }
 
   // we either found the item or we will load the first one by default
-  memcpy_P(&_mnuStack[_currMenu], &_mnuHdr[idx], sizeof(mnuHeader_t));
+  stackLoad(idx);
+}
+
+void MD_Menu::stackLoad(mnuId_t idx)
+// Load the menu header at the table position to the current stack position
+{
+#if MNU_STACK_COMPACT
+  _mnuStack[_currMenu].idx = idx;
+  MNU_READ_ID(_mnuStack[_currMenu].idItmCurr, _def->mnuHdr[idx].idItmCurr);
+#else
+  memcpy_P(&_mnuStack[_currMenu], &_def->mnuHdr[idx], sizeof(mnuHeader_t));
+#endif
+  STATS_INC(scanned);
+}
+
+MD_Menu::mnuId_t MD_Menu::stackItmStart(void)
+{
+#if MNU_STACK_COMPACT
+  mnuId_t id;
+
+  MNU_READ_ID(id, _def->mnuHdr[_mnuStack[_currMenu].idx].idItmStart);
+  return(id);
+#else
+  return(_mnuStack[_currMenu].idItmStart);
+#endif
+}
+
+MD_Menu::mnuId_t MD_Menu::stackItmEnd(void)
+{
+#if MNU_STACK_COMPACT
+  mnuId_t id;
+
+  MNU_READ_ID(id, _def->mnuHdr[_mnuStack[_currMenu].idx].idItmEnd);
+  return(id);
+#else
+  return(_mnuStack[_currMenu].idItmEnd);
+#endif
 }
 
-MD_Menu::mnuItem_t* MD_Menu::loadItem(mnuId_t id)
-// Find a copy the input item to the class private buffer
+const MD_Menu::mnuItem_t* MD_Menu::loadItem(mnuId_t id)
+// Find the menu item and return a pointer to it in the table (MNU_ZERO_COPY)
+// or to a copy in the class private buffer
 {
-  for (mnuId_t i = 0; i < _mnuItmCount; i++)
+  STATS_INC(lookups);
+
+#if MNU_INDEX
+  if (_def->idxItm.pos != nullptr)
   {
-    memcpy_P(&_mnuBufItem, &_mnuItm[i], sizeof(mnuItem_t));
+    mnuId_t i = lookupIndex(_def->idxItm, id);
+
+    if (i == -1) return(nullptr);
+    STATS_INC(scanned);
+#if MNU_ZERO_COPY
+    return(&_def->mnuItm[i]);
+#else
+    memcpy_P(&_mnuBufItem, &_def->mnuItm[i], sizeof(mnuItem_t));
+    return(&_mnuBufItem);
+#endif
+  }
+#endif
+
+  for (mnuId_t i = 0; i < _def->mnuItmCount; i++)
+  {
+    STATS_INC(scanned);
+#if MNU_ZERO_COPY
+    if (_def->mnuItm[i].id == id)
+      return(&_def->mnuItm[i]);
+#else
+    memcpy_P(&_mnuBufItem, &_def->mnuItm[i], sizeof(mnuItem_t));
     if (_mnuBufItem.id == id)
       return(&_mnuBufItem);
+#endif
   }
 
   return(nullptr);
 }
 
-MD_Menu::mnuInput_t* MD_Menu::loadInput(mnuId_t id)
-// Find a copy the input item to the class private buffer
+const MD_Menu::mnuInput_t* MD_Menu::loadInput(mnuId_t id)
+// Find the input item and return a pointer to it in the table (MNU_ZERO_COPY)
+// or to a copy in the class private buffer
 {
-  for (mnuId_t i = 0; i < _mnuInpCount; i++)
+  STATS_INC(lookups);
+
+#if MNU_INDEX
+  if (_def->idxInp.pos != nullptr)
+  {
+    mnuId_t i = lookupIndex(_def->idxInp, id);
+
+    if (i == -1) return(nullptr);
+    STATS_INC(scanned);
+#if MNU_ZERO_COPY
+    return(&_def->mnuInp[i]);
+#else
+    memcpy_P(&_mnuBufInput, &_def->mnuInp[i], sizeof(mnuInput_t));
+    return(&_mnuBufInput);
+#endif
+  }
+#endif
+
+  for (mnuId_t i = 0; i < _def->mnuInpCount; i++)
   {
-    memcpy_P(&_mnuBufInput, &_mnuInp[i], sizeof(mnuInput_t));
+    STATS_INC(scanned);
+#if MNU_ZERO_COPY
+    if (_def->mnuInp[i].id == id)
+      return(&_def->mnuInp[i]);
+#else
+    memcpy_P(&_mnuBufInput, &_def->mnuInp[i], sizeof(mnuInput_t));
     if (_mnuBufInput.id == id)
       return(&_mnuBufInput);
+#endif
   }
 
   return(nullptr);
@@ -184,21 +1305,121 @@ char *MD_Menu::getListItem(const char *p, MD_Menu::listId_t idx, char *buf, uint
   return(buf);
 }
 
-void MD_Menu::strPreamble(char *psz, mnuInput_t *mInp)
+MD_Menu::listId_t MD_Menu::listCacheBuild(const char *p)
+// Count the items in the list and remember where every _listStep'th item 
+// starts, so that moving through the list and redrawing do not rescan the 
+// string. The step is chosen so that MNU_LIST_CACHE_SIZE offsets cover the 
+// whole list, and an item is never more than _listStep - 1 items past its 
+// cached offset. The offsets are held in a fixed buffer shared by all the 
+// objects, owned by the object that last built it.
+{
+  listCacheClear();
+  _listCount = getListCount(p);
+
+#if MNU_LIST_CACHE_SIZE
+  if (_listCount != 0)
+  {
+    uint16_t ofs = 0;
+    uint16_t n = 1;
+    char c;
+
+    _listStep = (_listCount + MNU_LIST_CACHE_SIZE - 1) / MNU_LIST_CACHE_SIZE;
+    _listOfs[0] = 0;
+    for (listId_t i = 1; n < MNU_LIST_CACHE_SIZE && i < _listCount; i++)
+    {
+      do
+        c = pgm_read_byte(p + ofs++);
+      while (c != LIST_SEPARATOR);
+      if (i % _listStep == 0)
+        _listOfs[n++] = ofs;
+    }
+    _listOwner = this;
+  }
+#endif
+
+  return(_listCount);
+}
+
+void MD_Menu::listCacheClear(void)
+{
+#if MNU_LIST_CACHE_SIZE
+  if (_listOwner == this)
+    _listOwner = nullptr;
+#endif
+}
+
+char *MD_Menu::listCacheItem(const char *p, listId_t idx, char *buf, uint8_t bufLen)
+// Get the list item scanning from the nearest cached offset before it.
+// If another object has since used the cache, scan from the start of 
+// the list.
+{
+#if MNU_LIST_CACHE_SIZE
+  if (_listOwner == this && idx < _listCount)
+  {
+    listId_t k = idx / _listStep;
+
+    return(getListItem(p + _listOfs[k], idx - (k * _listStep), buf, bufLen));
+  }
+#endif
+
+  return(getListItem(p, idx, buf, bufLen));
+}
+
+#if MNU_VIRTUAL_ITEMS
+MD_Menu::listId_t MD_Menu::virtualCount(mnuId_t id)
+{
+  STATS_STACK();
+  return(_cbVirt != nullptr ? _cbVirt(id, VIRT_COUNT, 0, nullptr, 0) : 0);
+}
+
+char *MD_Menu::virtualItem(mnuId_t id, listId_t idx, char *buf, uint8_t bufLen, bool pad)
+// Get the label for a virtual item, optionally padded with trailing 
+// spaces to the fixed width like getListItem().
+{
+  uint8_t l;
+
+  STATS_STACK();
+  memset(buf, '\0', bufLen);
+  if (_cbVirt != nullptr)
+    _cbVirt(id, VIRT_LABEL, idx, buf, bufLen);
+  buf[bufLen - 1] = '\0';   // in case the callback filled the buffer
+
+  if (pad)
+  {
+    l = strlen(buf);
+    while (l < bufLen - 1)
+      buf[l++] = ' ';
+  }
+
+  return(buf);
+}
+#endif
+
+char *MD_Menu::strAppend(char *psz, const char *s)
+// Copy the string to psz and return a pointer to the terminating '\0',
+// so that strings can be built up without rescanning them
+{
+  while ((*psz = *s++) != '\0')
+    psz++;
+
+  return(psz);
+}
+
+char *MD_Menu::strPreamble(char *psz, const mnuInput_t *mInp)
 // Create the start to a variable CB_DISP
 {
-  strcpy(psz, mInp->label);
-  strcat(psz, FLD_PROMPT);
-  strcat(psz, FLD_DELIM_L);
+  psz = strAppend(psz, mInp->label);
+  psz = strAppend(psz, FLD_PROMPT);
+  return(strAppend(psz, FLD_DELIM_L));
 }
 
-void MD_Menu::strPostamble(char *psz, mnuInput_t *mInp)
-// Attach the tail of the variable CB_DISP
+char *MD_Menu::strPostamble(char *psz)
+// Attach the tail of the variable CB_DISP at psz
 {
-  strcat(psz, FLD_DELIM_R);
+  return(strAppend(psz, FLD_DELIM_R));
 }
 
-bool MD_Menu::processList(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
+bool MD_Menu::processList(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb)
 // Processing for List based input
 // Return true when the edit cycle is completed
 {
@@ -209,7 +1430,17 @@ bool MD_Menu::processList(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
   {
   case NAV_NULL:    // this is to initialize the CB_DISP
   {
-    listId_t size = getListCount(mInp->pList);
+    listId_t size;
+
+#if MNU_VIRTUAL_ITEMS
+    if (mInp->pList == nullptr)   // virtual list
+    {
+      listCacheClear();
+      size = _listCount = virtualCount(mInp->id);
+    }
+    else
+#endif
+      size = listCacheBuild(mInp->pList);
 
     if (size == 0)
     {
@@ -218,7 +1449,7 @@ bool MD_Menu::processList(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
     }
     else
     {
-      _pValue = mInp->cbVR(mInp->id, true);
+      _pValue = valueRequest(mInp, true);
 
       if (_pValue == nullptr)
       {
@@ -238,41 +1469,47 @@ bool MD_Menu::processList(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
 
   case NAV_DEC:
     {
-      listId_t size = getListCount(mInp->pList);
+      listId_t size = _listCount;
 
-      if (_V.value > 0)
-      {
-        _V.value--;
-        update = true;
-      }
-      else if (_V.value == 0 && TEST_FLAG(F_MENUWRAP))
+      for (uint16_t i = 0; i < _navRepeat; i++)
       {
-        _V.value = size - 1;
-        update = true;
+        if (_V.value > 0)
+        {
+          _V.value--;
+          update = true;
+        }
+        else if (_V.value == 0 && TEST_FLAG(F_MENUWRAP))
+        {
+          _V.value = size - 1;
+          update = true;
+        }
       }
     }
     break;
 
   case NAV_INC:
     {
-      listId_t size = getListCount(mInp->pList);
+      listId_t size = _listCount;
 
-      if (_V.value < size - 1)
+      for (uint16_t i = 0; i < _navRepeat; i++)
       {
-        _V.value++;
-        update = true;
-      }
-      else if (_V.value == size - 1 && TEST_FLAG(F_MENUWRAP))
-      {
-        _V.value = 0;
-        update = true;
+        if (_V.value < size - 1)
+        {
+          _V.value++;
+          update = true;
+        }
+        else if (_V.value == size - 1 && TEST_FLAG(F_MENUWRAP))
+        {
+          _V.value = 0;
+          update = true;
+        }
       }
     }
     break;
 
   case NAV_SEL:
     _pValue->value = _V.value;
-    mInp->cbVR(mInp->id, false);
+    valueRequest(mInp, false);
     endFlag = true;
     break;
 
@@ -283,27 +1520,29 @@ bool MD_Menu::processList(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
 
   if (update)
   {
-    char szItem[mInp->fieldWidth + 1];
-    char sz[INP_PRE_SIZE(mInp) + sizeof(szItem) + INP_POST_SIZE(mInp) + 1];
+    uint8_t fw = fieldWidth(mInp);
+    char *p = strPreamble(_lineBuf, mInp);
 
-    strPreamble(sz, mInp);
-    strcat(sz, getListItem(mInp->pList, _V.value, szItem, sizeof(szItem)));
-    strPostamble(sz, mInp);
+    // always padded to the field width
+#if MNU_VIRTUAL_ITEMS
+    if (mInp->pList == nullptr)
+      virtualItem(mInp->id, _V.value, p, fw + 1, true);
+    else
+#endif
+      listCacheItem(mInp->pList, _V.value, p, fw + 1);
+    strPostamble(p + fw);
 
-    _cbDisp(DISP_L1, sz);
+    display(DISP_L1, _lineBuf);
 
     // real time feedback needed
     if (rtfb)
-    {
-      _pValue->value = _V.value;
-      mInp->cbVR(mInp->id, false);
-    }
+      feedback(mInp);
   }
 
   return(endFlag);
 }
 
-bool MD_Menu::processBool(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
+bool MD_Menu::processBool(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb)
 // Processing for Boolean (true/false) value input
 // Return true when the edit cycle is completed
 {
@@ -314,7 +1553,7 @@ bool MD_Menu::processBool(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
   {
   case NAV_NULL:    // this is to initialize the CB_DISP
     {
-      _pValue = mInp->cbVR(mInp->id, true);
+      _pValue = valueRequest(mInp, true);
 
       if (_pValue == nullptr)
       {
@@ -331,13 +1570,13 @@ bool MD_Menu::processBool(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
 
   case NAV_INC:
   case NAV_DEC:
-    _V.value = !_V.value;
+    if (_navRepeat & 1) _V.value = !_V.value;   // an even number of changes ends up the same
     update = true;
     break;
 
   case NAV_SEL:
     _pValue->value = _V.value;
-    mInp->cbVR(mInp->id, false);
+    valueRequest(mInp, false);
     endFlag = true;
     break;
 
@@ -348,49 +1587,107 @@ bool MD_Menu::processBool(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
 
   if (update)
   {
-    char sz[INP_PRE_SIZE(mInp) + strlen(INP_BOOL_T) + INP_POST_SIZE(mInp) + 1];
+    char *p = strPreamble(_lineBuf, mInp);
 
-    strPreamble(sz, mInp);
-    strcat(sz, _V.value ? INP_BOOL_T : INP_BOOL_F);
-    strPostamble(sz, mInp);
+    p = strAppend(p, _V.value ? INP_BOOL_T : INP_BOOL_F);
+    strPostamble(p);
 
-    _cbDisp(DISP_L1, sz);
+    display(DISP_L1, _lineBuf);
 
     // real time feedback needed
     if (rtfb)
-    {
-      _pValue->value = _V.value;
-      mInp->cbVR(mInp->id, false);
-    }
+      feedback(mInp);
   }
 
   return(endFlag);
 }
 
-char *MD_Menu::ltostr(char *buf, uint8_t bufLen, int32_t v, uint8_t base, bool sign, bool leadZero)
+char *MD_Menu::ltostr(char *buf, uint8_t bufLen, int32_t v, uint8_t base, bool sign, bool leadZero, uint8_t decimals)
 // Convert a long to a string right justified with leading spaces
-// in the base specified (up to 16).
+// in the base specified (2 to 16, anything else is taken as base 10).
+// If decimals is not zero, a decimal
+// point is inserted before the last decimals digits, with a leading 
+// zero if needed (eg, 0.05).
+// The digits are worked out least significant first into a scratch buffer.
+// Division is slow on small processors, so power of 2 bases use shift 
+// and mask and base 10 only does a 32 bit division for every 4 digits, 
+// with the digits in each 16 bit chunk split off using multiplication 
+// by the reciprocal of 10.
 {
+  static const char hexDigit[] = "0123456789ABCDEF";
+  char digit[32];   // enough for 32 bits in base 2
+  uint8_t n = 0;    // number of digits in digit[]
+  uint8_t i;
   char *ptr = buf + bufLen - 1; // the last element of the buffer
-  uint32_t t = 0, res = 0;
-  uint32_t value = (sign ? -v : v);
+  uint32_t value = (sign ? -(uint32_t)v : v);
 
   if (buf == nullptr) return(nullptr);
+  if (base < 2 || base > 16) base = 10;
 
-  *ptr = '\0'; // terminate the string as we will be moving backwards
+  if ((base & (base - 1)) == 0)   // power of 2
+  {
+    uint8_t shift = 0;
 
-  // now successively deal with the remainder digit 
-  // until we have value == 0
-  do
+    while ((1 << shift) < base) shift++;
+    do
+    {
+      digit[n++] = hexDigit[value & (base - 1)];
+      value >>= shift;
+    } while (value != 0 && n < sizeof(digit));
+  }
+  else if (base == 10)
+  {
+    uint16_t chunk;
+
+    while (value >= 10000 && n <= sizeof(digit) - 4)
+    {
+      uint32_t t = value / 10000;
+
+      chunk = value - (t * 10000);
+      for (i = 0; i < 4; i++)
+      {
+        uint16_t q = ((uint32_t)chunk * 0xcccd) >> 19;  // chunk/10, exact for chunk < 81920
+
+        digit[n++] = '0' + (chunk - (q * 10));
+        chunk = q;
+      }
+      value = t;
+    }
+
+    chunk = value;
+    do
+    {
+      uint16_t q = ((uint32_t)chunk * 0xcccd) >> 19;
+
+      digit[n++] = '0' + (chunk - (q * 10));
+      chunk = q;
+    } while (chunk != 0 && n < sizeof(digit));
+  }
+  else
   {
-    t = value / base;
-    res = value - (base * t);
-    if (res < 10)
-      *--ptr = '0' + res;
-    else if ((res >= 10) && (res < 16))
-      *--ptr = 'A' - 10 + res;
-    value = t;
-  } while (value != 0 && ptr != buf);
+    do
+    {
+      uint32_t t = value / base;
+
+      digit[n++] = hexDigit[(value - (base * t)) & 0xf];
+      value = t;
+    } while (value != 0 && n < sizeof(digit));
+  }
+
+  while (decimals != 0 && n <= decimals && n < sizeof(digit))  // leading zero for decimals
+    digit[n++] = '0';
+
+  // now copy the digits into the buffer, working backwards
+  *ptr = '\0';
+  for (i = 0; i < n && ptr != buf; i++)
+  {
+    if (i == decimals && i != 0)
+    {
+      *--ptr = DECIMAL_POINT;
+      if (ptr == buf) break;
+    }
+    *--ptr = digit[i];
+  }
 
   if (ptr != buf)      // if there is still space
   {
@@ -398,58 +1695,213 @@ char *MD_Menu::ltostr(char *buf, uint8_t bufLen, int32_t v, uint8_t base, bool s
     while (ptr != buf)       // ... and pad with leading character
       *--ptr = (leadZero ? '0' : ' ');
   }
-  else if (value != 0 || sign) // insufficient space - show this
-      *ptr = INP_NUMERIC_OFLOW;
+  else if (i < n || sign) // insufficient space - show this
+      *ptr = INP_NUMERIC_OFLOW;
+
+  return(buf);
+}
+
+bool MD_Menu::processInt(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb, uint16_t incDelta)
+// Processing for Integer (all sizes) value input
+// Return true when the edit cycle is completed
+{
+  bool endFlag = false;
+  bool update = false;
+
+  switch (nav)
+  {
+  case NAV_NULL:    // this is to initialize the CB_DISP
+    {
+      _pValue = valueRequest(mInp, true);
+
+      if (_pValue == nullptr)
+      {
+        MD_PRINTS("\nInt cbVR(GET) == NULL!");
+        endFlag = true;
+      }
+      else
+      {
+        _V.value = _pValue->value;
+        update = true;
+      }
+    }
+    break;
+
+  case NAV_INC:
+    if (_V.value + incDelta <= mInp->range[1].value)
+      _V.value += incDelta;
+#if MNU_ACCEL
+    else if (_accelMult > 1)
+      _V.value = mInp->range[1].value;    // accelerated change stops at max value
+#endif
+    else
+      _V.value = mInp->range[0].value;    // wrap around to min value
+    update = true;
+    break;
+
+  case NAV_DEC:
+    if (_V.value - incDelta >= mInp->range[0].value)
+      _V.value -= incDelta;
+#if MNU_ACCEL
+    else if (_accelMult > 1)
+      _V.value = mInp->range[0].value;    // accelerated change stops at min value
+#endif
+    else
+      _V.value = mInp->range[1].value;    // wrap around to max value
+    update = true;
+    break;
+
+  case NAV_SEL:
+    _pValue->value = _V.value;
+    valueRequest(mInp, false);
+    endFlag = true;
+    break;
+
+  case NAV_ESC:
+    // do nothing except stop compiler warnings
+    break;
+  }
+
+  if (update)
+  {
+    uint8_t fw = fieldWidth(mInp);
+    char *p = strPreamble(_lineBuf, mInp);
+
+    ltostr(p, fw + 1, _V.value, mInp->base, (_V.value < 0));
+    strPostamble(p + fw);
+
+    display(DISP_L1, _lineBuf);
+
+    // real time feedback needed
+    if (rtfb)
+      feedback(mInp);
+  }
 
-  return(buf);
+  return(endFlag);
 }
 
-bool MD_Menu::processInt(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint16_t incDelta)
-// Processing for Integer (all sizes) value input
+#if MNU_DIGIT_EDIT
+bool MD_Menu::processDigit(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb, uint16_t incDelta)
+// Processing for digit by digit editing of INP_INT and INP_FLOAT values.
+// _digitPos is the digit being edited, 0 for the least significant. If 
+// the range allows negative values the position above the top digit is
+// the sign, kept in a flag so that it can be set before the digits.
+// SEL moves to the next lower digit and confirms after the last digit.
 // Return true when the edit cycle is completed
 {
   bool endFlag = false;
   bool update = false;
+  uint8_t decimals = (mInp->action == INP_FLOAT ? FLOAT_DECIMALS : 0);
+  uint8_t base = (mInp->action == INP_FLOAT ? 10 : mInp->base);
+  bool hasSign = (mInp->range[0].value < 0);
+  uint8_t fw = fieldWidth(mInp);
+  uint8_t digits = 0;   // number of digits being edited
+  uint8_t width;        // chars for the digits and decimal point
+  uint32_t mag;         // magnitude of the value
+
+  if (base < 2 || base > 16) base = 10;   // as for ltostr()
+
+  // work out the number of digits needed for the range that fit the field
+  {
+    uint32_t rMin = (hasSign ? -(uint32_t)mInp->range[0].value : mInp->range[0].value);
+    uint32_t rMax = (mInp->range[1].value < 0 ? -(uint32_t)mInp->range[1].value : mInp->range[1].value);
+    int16_t maxDigits = fw - (decimals != 0 ? 1 : 0) - (hasSign ? 1 : 0);
+
+    mag = (rMin > rMax ? rMin : rMax);
+    do
+    {
+      digits++;
+      mag /= base;
+    } while (mag != 0);
+    if (digits > maxDigits) digits = (maxDigits < 1 ? 1 : maxDigits);
+    if (digits < decimals + 1) digits = decimals + 1;
+
+    // a field too narrow for the sign, point and one whole digit is widened to fit
+    width = digits + (decimals != 0 ? 1 : 0);
+    if (fw < width + (hasSign ? 1 : 0)) fw = width + (hasSign ? 1 : 0);
+  }
 
   switch (nav)
   {
   case NAV_NULL:    // this is to initialize the CB_DISP
     {
-      _pValue = mInp->cbVR(mInp->id, true);
+      _pValue = valueRequest(mInp, true);
 
       if (_pValue == nullptr)
       {
-        MD_PRINTS("\nInt cbVR(GET) == NULL!");
+        MD_PRINTS("\nDigit cbVR(GET) == NULL!");
         endFlag = true;
       }
       else
       {
         _V.value = _pValue->value;
+        if (_V.value < mInp->range[0].value) _V.value = mInp->range[0].value;
+        if (_V.value > mInp->range[1].value) _V.value = mInp->range[1].value;
+        if (_V.value < 0) { SET_FLAG(F_DIGITNEG); } else { CLEAR_FLAG(F_DIGITNEG); }
+        _digitPos = (hasSign ? digits : digits - 1);
         update = true;
       }
     }
     break;
 
   case NAV_INC:
-    if (_V.value + incDelta <= mInp->range[1].value)
-      _V.value += incDelta;
+  case NAV_DEC:
+    mag = (_V.value < 0 ? -(uint32_t)_V.value : _V.value);
+    if (_digitPos == digits)   // the sign
+    {
+      if (_navRepeat & 1)   // an even number of changes ends up the same
+      {
+        if (TEST_FLAG(F_DIGITNEG)) { CLEAR_FLAG(F_DIGITNEG); } else { SET_FLAG(F_DIGITNEG); }
+      }
+    }
     else
-      _V.value = mInp->range[0].value;    // wrap around to min value
-    update = true;
-    break;
+    {
+      uint32_t p = 1;
+      uint8_t d, dNew, step = incDelta % base;
+      uint16_t carry = incDelta / base;   // whole steps of the base change the higher digits
 
-  case NAV_DEC:
-    if (_V.value - incDelta >= mInp->range[0].value)
-      _V.value -= incDelta;
+      for (uint8_t i = 0; i < _digitPos; i++)
+        p *= base;
+
+      d = (mag / p) % base;
+      dNew = (nav == NAV_INC ? (d + step) % base : (d + base - step) % base);
+      mag -= d * p;
+      mag = (dNew > (0xffffffff - mag) / p ? 0xffffffff : mag + (dNew * p));  // dNew * p can overflow
+
+      if (carry != 0 && p <= 0xffffffff / base)   // there are higher digits
+      {
+        uint32_t c = p * base;
+
+        c = (carry > 0xffffffff / c ? 0xffffffff : carry * c);
+        if (nav == NAV_INC)
+          mag = (c > 0xffffffff - mag ? 0xffffffff : mag + c);
+        else
+          mag = (c > mag ? 0 : mag - c);
+      }
+    }
+
+    // put the sign back and keep in range
+    if (TEST_FLAG(F_DIGITNEG))
+      _V.value = (mag > 0x80000000 ? (int32_t)0x80000000 : -(int32_t)(mag - 1) - 1);
     else
-      _V.value = mInp->range[1].value;    // wrap around to max value
+      _V.value = (mag > 0x7fffffff ? 0x7fffffff : (int32_t)mag);
+    if (_V.value < mInp->range[0].value) _V.value = mInp->range[0].value;
+    if (_V.value > mInp->range[1].value) _V.value = mInp->range[1].value;
     update = true;
     break;
 
   case NAV_SEL:
-    _pValue->value = _V.value;
-    mInp->cbVR(mInp->id, false);
-    endFlag = true;
+    if (_digitPos != 0)
+    {
+      _digitPos--;
+      update = true;
+    }
+    else
+    {
+      _pValue->value = _V.value;
+      valueRequest(mInp, false);
+      endFlag = true;
+    }
     break;
 
   case NAV_ESC:
@@ -459,26 +1911,38 @@ bool MD_Menu::processInt(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint1
 
   if (update)
   {
-    char sz[INP_PRE_SIZE(mInp) + mInp->fieldWidth + INP_POST_SIZE(mInp) + 1];
-
-    strPreamble(sz, mInp);
-    ltostr(sz + strlen(sz), mInp->fieldWidth + 1, _V.value, mInp->base, (_V.value < 0));
-    strPostamble(sz, mInp);
-
-    _cbDisp(DISP_L1, sz);
+    char *p = strPreamble(_lineBuf, mInp);
+    uint8_t col = (p - _lineBuf) + fw - 1;   // column of the last digit
+
+    // digits with leading zeros, right justified in the field, and the sign
+    memset(p, ' ', fw - width);
+    mag = (_V.value < 0 ? -(uint32_t)_V.value : _V.value);
+    ltostr(p + fw - width, width + 1, mag, base, false, true, decimals);
+    if (hasSign)
+      p[fw - width - 1] = (TEST_FLAG(F_DIGITNEG) ? '-' : '+');
+    strPostamble(p + fw);
+
+    display(DISP_L1, _lineBuf);
+
+    // show where the cursor is
+    if (_digitPos == digits)
+      col -= width;
+    else
+      col -= _digitPos + (decimals != 0 && _digitPos >= decimals ? 1 : 0);
+    _dispLine = 1;
+    _dispCol = col;
+    display(DISP_CURSOR);
 
     // real time feedback needed
     if (rtfb)
-    {
-      _pValue->value = _V.value;
-      mInp->cbVR(mInp->id, false);
-    }
+      feedback(mInp);
   }
 
   return(endFlag);
 }
+#endif
 
-bool MD_Menu::processFloat(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint16_t incDelta)
+bool MD_Menu::processFloat(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb, uint16_t incDelta)
 // Processing for Floating number representation value input
 // The number is actually a uint32, where the last FLOAT_DECIMALS digits are taken
 // to be fractional part of the floating number. For all purposes, this number is a long
@@ -488,12 +1952,13 @@ bool MD_Menu::processFloat(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uin
 {
   bool endFlag = false;
   bool update = false;
+  int32_t step = (int32_t)incDelta * mInp->base;  // in 32 bits, as an accelerated step overflows a 16 bit int
 
   switch (nav)
   {
   case NAV_NULL:    // this is to initialize the CB_DISP
   {
-    _pValue = mInp->cbVR(mInp->id, true);
+    _pValue = valueRequest(mInp, true);
 
     if (_pValue == nullptr)
     {
@@ -509,16 +1974,16 @@ bool MD_Menu::processFloat(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uin
   break;
 
   case NAV_INC:
-    if (_V.value + (incDelta * mInp->base) <= mInp->range[1].value)
-      _V.value += (incDelta * mInp->base);
+    if (_V.value + step <= mInp->range[1].value)
+      _V.value += step;
     else
       _V.value = mInp->range[1].value;
     update = true;
     break;
 
   case NAV_DEC:
-    if (_V.value - (incDelta * mInp->base) >= mInp->range[0].value)
-      _V.value -= (incDelta * mInp->base);
+    if (_V.value - step >= mInp->range[0].value)
+      _V.value -= step;
     else
       _V.value = mInp->range[0].value;
     update = true;
@@ -526,7 +1991,7 @@ bool MD_Menu::processFloat(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uin
 
   case NAV_SEL:
     _pValue->value = _V.value;
-    mInp->cbVR(mInp->id, false);
+    valueRequest(mInp, false);
     endFlag = true;
     break;
 
@@ -537,34 +2002,23 @@ bool MD_Menu::processFloat(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uin
 
   if (update)
   {
-    uint16_t divisor = 1;
-    char sz[INP_PRE_SIZE(mInp) + mInp->fieldWidth + INP_POST_SIZE(mInp) + 1];
-
-    for (uint8_t i = 0; i < FLOAT_DECIMALS; i++)
-      divisor *= 10;
+    uint8_t fw = fieldWidth(mInp);
+    char *p = strPreamble(_lineBuf, mInp);
 
-    strPreamble(sz, mInp);
-    ltostr(sz + strlen(sz), mInp->fieldWidth - (FLOAT_DECIMALS + 1) + 1, _V.value / divisor, 10, (_V.value < 0));
-    sz[strlen(sz) + 1] = '\0';
-    sz[strlen(sz)] = DECIMAL_POINT;
-    ltostr(sz + strlen(sz), (FLOAT_DECIMALS + 1), abs(_V.value % divisor), 10, false, true);
+    ltostr(p, fw + 1, _V.value, 10, (_V.value < 0), false, FLOAT_DECIMALS);
+    strPostamble(p + fw);
 
-    strPostamble(sz, mInp);
-
-    _cbDisp(DISP_L1, sz);
+    display(DISP_L1, _lineBuf);
 
     // real time feedback needed
     if (rtfb)
-    {
-      _pValue->value = _V.value;
-      mInp->cbVR(mInp->id, false);
-    }
+      feedback(mInp);
   }
 
   return(endFlag);
 }
 
-bool MD_Menu::processEng(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint16_t incDelta)
+bool MD_Menu::processEng(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb, uint16_t incDelta)
 // Processing for Engineering Units number value input
 // The number is actually a uint32, where the last ENGU_DECIMALS digits are taken
 // to be fractional part of the floating number. For all purposes, this number is a long
@@ -574,12 +2028,13 @@ bool MD_Menu::processEng(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint1
 {
   bool endFlag = false;
   bool update = false;
+  int32_t step = (int32_t)incDelta * mInp->base;  // in 32 bits, as an accelerated step overflows a 16 bit int
 
   switch (nav)
   {
   case NAV_NULL:    // this is to initialize the CB_DISP
   {
-    _pValue = mInp->cbVR(mInp->id, true);
+    _pValue = valueRequest(mInp, true);
 
     if (_pValue == nullptr)
     {
@@ -598,17 +2053,17 @@ bool MD_Menu::processEng(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint1
   break;
 
   case NAV_INC:
-    if ((_V.value + (incDelta * mInp->base))/1000 < 1000)  // still within the same prefix range
+    if ((_V.value + step)/1000 < 1000)  // still within the same prefix range
     {
       if ((_V.power < mInp->range[1].power) ||
-         (_V.power == mInp->range[1].power && _V.value + (incDelta * mInp->base) <= mInp->range[1].value))
-        _V.value += (incDelta * mInp->base);
+         (_V.power == mInp->range[1].power && _V.value + step <= mInp->range[1].value))
+        _V.value += step;
       else
         _V.value = mInp->range[1].value;
     }
     else  // moved into the next range
     {
-      _V.value += (incDelta * mInp->base);
+      _V.value += step;
       _V.value /= 1000;
       _V.power += 3;
       if ((_V.power > mInp->range[1].power) ||
@@ -622,11 +2077,11 @@ bool MD_Menu::processEng(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint1
     break;
 
   case NAV_DEC:
-    if ((_V.value - (incDelta * mInp->base)) / 1000 > 0)  // still within the same prefix range
+    if ((_V.value - step) / 1000 > 0)  // still within the same prefix range
     {
       if ((_V.power > mInp->range[0].power) ||
-         (_V.power == mInp->range[0].power && _V.value - (incDelta * mInp->base) >= mInp->range[0].value))
-        _V.value -= (incDelta * mInp->base);
+         (_V.power == mInp->range[0].power && _V.value - step >= mInp->range[0].value))
+        _V.value -= step;
       else
         _V.value = mInp->range[0].value;
     }
@@ -637,7 +2092,7 @@ bool MD_Menu::processEng(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint1
         _V.value *= 1000;
         _V.power -= 3;
       }
-      _V.value -= (incDelta * mInp->base);    // adjust the value
+      _V.value -= step;    // adjust the value
 
       if (_V.power == mInp->range[0].power && _V.value <= mInp->range[0].value)
       {
@@ -651,7 +2106,7 @@ bool MD_Menu::processEng(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint1
   case NAV_SEL:
     _pValue->value = _V.value;
     _pValue->power = _V.power;
-    mInp->cbVR(mInp->id, false);
+    valueRequest(mInp, false);
     endFlag = true;
     break;
 
@@ -667,70 +2122,64 @@ bool MD_Menu::processEng(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint1
     // micro(-6), milli(-3), blank(0), kilo(3), Mega(6), Giga(9), Tera(12), Peta(15), Exa(18).
     static char unitsPrefix[] = { "afpnum kMGTPE" };
 
-    uint16_t divisor = 1;
-    char sz[INP_PRE_SIZE(mInp) + mInp->fieldWidth + INP_POST_SIZE(mInp) + 1 + strlen_P(mInp->pList) + 1];
-
-    // work out the divisor we need
-    for (uint8_t i = 0; i < ENGU_DECIMALS; i++)
-      divisor *= 10;
-
-    strPreamble(sz, mInp);
-    ltostr(sz + strlen(sz), mInp->fieldWidth - (ENGU_DECIMALS + 1) + 1, _V.value / divisor, 10, (_V.value < 0));
-    sz[strlen(sz) + 1] = '\0';
-    sz[strlen(sz)] = DECIMAL_POINT;
-    ltostr(sz + strlen(sz), (ENGU_DECIMALS + 1), abs(_V.value % divisor), 10, false, true);
+    uint8_t fw = fieldWidth(mInp);
+    char *p = strPreamble(_lineBuf, mInp);
+    size_t len = strlen_P(mInp->pList);
 
-    strPostamble(sz, mInp);
-    sz[strlen(sz) + 1] = '\0';
-    sz[strlen(sz)] = unitsPrefix[(strlen(unitsPrefix) / 2) + (_V.power / 3)]; // milli, kilo, etc
-    strcat_P(sz, mInp->pList);
+    ltostr(p, fw + 1, _V.value, 10, (_V.value < 0), false, ENGU_DECIMALS);
+    p = strPostamble(p + fw);
+    *p++ = unitsPrefix[((sizeof(unitsPrefix) - 1) / 2) + (_V.power / 3)]; // milli, kilo, etc
+    if (len > MNU_UNITS_SIZE) len = MNU_UNITS_SIZE;
+    memcpy_P(p, mInp->pList, len);
+    p[len] = '\0';
 
-    _cbDisp(DISP_L1, sz);
+    display(DISP_L1, _lineBuf);
 
     // real time feedback needed
     if (rtfb)
-    {
-      _pValue->value = _V.value;
-      mInp->cbVR(mInp->id, false);
-    }
+      feedback(mInp);
   }
 
   return(endFlag);
 }
 
-bool MD_Menu::processRun(userNavAction_t nav, mnuInput_t *mInp, bool rtfb)
+bool MD_Menu::processRun(userNavAction_t nav, const mnuInput_t *mInp)
 // Processing for Run user code input field.
 // When the field is selected, run the user variable code. For all other
 // input do nothing. Return true when the element has run user code.
 {
   if (nav == NAV_NULL)    // initialize the CB_DISP
   {
-    _pValue = mInp->cbVR(mInp->id, true);
+    _pValue = valueRequest(mInp, true);
 
+#if MNU_ASYNC
+    if (TEST_FLAG(F_ASYNCWAIT))   // wait to find out if confirmation is required
+      return(false);
+#endif
     if (_pValue == nullptr) // no confirmation required, just run user code
     {
-      mInp->cbVR(mInp->id, false);
+      valueRequest(mInp, false);
       return(true);
     }
     else   // confirmation required
     {
-      char sz[INP_PRE_SIZE(mInp) + INP_POST_SIZE(mInp) + 1];
-      strcpy(sz, FLD_DELIM_L);
-      strcat(sz, mInp->label);
-      strcat(sz, FLD_DELIM_R);
-      _cbDisp(DISP_L1, sz);
+      char *p = strAppend(_lineBuf, FLD_DELIM_L);
+
+      p = strAppend(p, mInp->label);
+      strAppend(p, FLD_DELIM_R);
+      display(DISP_L1, _lineBuf);
     }
   }
   else if (nav == NAV_SEL)  // confirmation received
   {
-    mInp->cbVR(mInp->id, false);
+    valueRequest(mInp, false);
     return(true);
   }
 
   return(false);
 }
 
-bool MD_Menu::processExt(userNavAction_t nav, mnuInput_t* mInp, bool init, bool rtfb)
+bool MD_Menu::processExt(userNavAction_t nav, const mnuInput_t *mInp, bool init, bool rtfb)
 // Processing for Externally supplied values input
 // Return true when the edit cycle is completed
 {
@@ -741,8 +2190,18 @@ bool MD_Menu::processExt(userNavAction_t nav, mnuInput_t* mInp, bool init, bool
   {
   case NAV_NULL:    // this is to get the value from the user code
   {
-    _pValue = mInp->cbVR(mInp->id, true);
+    value_t *pv = valueRequest(mInp, true);
 
+#if MNU_ASYNC
+    if (pv == nullptr && !init && TEST_FLAG(F_ASYNCWAIT))
+    {
+      // keep showing the last value, the next poll picks up the completed request
+      CLEAR_FLAG(F_ASYNCWAIT);
+      break;
+    }
+#endif
+
+    _pValue = pv;
     if (_pValue == nullptr)
     {
       MD_PRINTS("\nExt cbVR(GET) == NULL!");
@@ -762,7 +2221,7 @@ bool MD_Menu::processExt(userNavAction_t nav, mnuInput_t* mInp, bool init, bool
 
   case NAV_SEL:
     _pValue->value = _V.value;
-    mInp->cbVR(mInp->id, false);
+    valueRequest(mInp, false);
     endFlag = true;
     break;
 
@@ -773,20 +2232,17 @@ bool MD_Menu::processExt(userNavAction_t nav, mnuInput_t* mInp, bool init, bool
 
   if (update || init)
   {
-    char sz[INP_PRE_SIZE(mInp) + mInp->fieldWidth + INP_POST_SIZE(mInp) + 1];
+    uint8_t fw = fieldWidth(mInp);
+    char *p = strPreamble(_lineBuf, mInp);
 
-    strPreamble(sz, mInp);
-    ltostr(sz + strlen(sz), mInp->fieldWidth + 1, _V.value, mInp->base, (_V.value < 0));
-    strPostamble(sz, mInp);
+    ltostr(p, fw + 1, _V.value, mInp->base, (_V.value < 0));
+    strPostamble(p + fw);
 
-    _cbDisp(DISP_L1, sz);
+    display(DISP_L1, _lineBuf);
 
     // real time feedback needed
     if (rtfb)
-    {
-      _pValue->value = _V.value;
-      mInp->cbVR(mInp->id, false);
-    }
+      feedback(mInp);
   }
 
   return(endFlag);
@@ -796,37 +2252,96 @@ void MD_Menu::handleInput(bool bNew)
 {
   bool ended = false;
   uint16_t incDelta = 1;
-  mnuItem_t *mi;
-  mnuInput_t *me;
+  const mnuItem_t *mi;
+  const mnuInput_t *me;
 
   if (bNew)
   {
-    _cbDisp(DISP_CLEAR, nullptr);
+    display(DISP_CLEAR);
     mi = loadItem(_mnuStack[_currMenu].idItmCurr);
-    _cbDisp(DISP_L0, mi->label);
+    strcpy(_lineBuf, mi->label);   // never pass the callback a pointer into the menu tables
+    display(DISP_L0, _lineBuf);
     me = loadInput(mi->actionId);
     if ((me == nullptr) || (me->cbVR == nullptr))
       ended = true;
     else
     {
       SET_FLAG(F_INEDIT);
+#if MNU_FB_RATE
+      CLEAR_FLAG(F_FBPENDING);
+      _timeFeedback = millis() - _fbInterval;  // first feedback is not held back
+#endif
+#if MNU_ACCEL
+      _accelNav = NAV_NULL;   // new run for acceleration
+      _accelMult = 1;
+#endif
       timerStart();
 
       switch (me->action)
       {
       case INP_LIST:  ended = processList(NAV_NULL, me, mi->action == MNU_INPUT_FB);            break;
       case INP_BOOL:  ended = processBool(NAV_NULL, me, mi->action == MNU_INPUT_FB);            break;
-      case INP_INT:   ended = processInt(NAV_NULL, me, mi->action == MNU_INPUT_FB, incDelta);   break;
-      case INP_FLOAT: ended = processFloat(NAV_NULL, me, mi->action == MNU_INPUT_FB, incDelta); break;
+      case INP_INT:
+#if MNU_DIGIT_EDIT
+        if (DIGIT_EDIT(me))
+          ended = processDigit(NAV_NULL, me, mi->action == MNU_INPUT_FB, incDelta);
+        else
+#endif
+          ended = processInt(NAV_NULL, me, mi->action == MNU_INPUT_FB, incDelta);
+        break;
+      case INP_FLOAT:
+#if MNU_DIGIT_EDIT
+        if (DIGIT_EDIT(me))
+          ended = processDigit(NAV_NULL, me, mi->action == MNU_INPUT_FB, incDelta);
+        else
+#endif
+          ended = processFloat(NAV_NULL, me, mi->action == MNU_INPUT_FB, incDelta);
+        break;
       case INP_ENGU:  ended = processEng(NAV_NULL, me, mi->action == MNU_INPUT_FB, incDelta);   break;
-      case INP_RUN:   ended = processRun(NAV_NULL, me, mi->action == MNU_INPUT_FB);             break;
+      case INP_RUN:   ended = processRun(NAV_NULL, me);                                         break;
       case INP_EXT:   ended = processExt(NAV_NULL, me, true, mi->action == MNU_INPUT_FB);       break;
       }
+
+#if MNU_ASYNC
+      if (TEST_FLAG(F_ASYNCWAIT))   // value requested, wait for it
+      {
+        ended = false;
+        asyncShow(me);
+      }
+#endif
+    }
+  }
+#if MNU_ASYNC
+  else if (TEST_FLAG(F_ASYNCWAIT))
+  {
+    // Waiting for completeValueRequest(), only ESC is acted on
+    userNavAction_t nav = getNav(incDelta);
+
+    if (nav != NAV_NULL) timerStart();
+
+    if (_asyncDone)
+    {
+      if (TEST_FLAG(F_ASYNCSET))
+      {
+        asyncCancel();
+        ended = true;       // the value has been set
+      }
+      else
+      {
+        CLEAR_FLAG(F_ASYNCWAIT);
+        _stateNext = ST_INPUT;  // start the edit again with the value received
+      }
+    }
+    else if (nav == NAV_ESC)
+    {
+      asyncCancel();
+      ended = true;
     }
   }
+#endif
   else
   {
-    userNavAction_t nav = _cbNav(incDelta);
+    userNavAction_t nav = getNav(incDelta);
     mi = loadItem(_mnuStack[_currMenu].idItmCurr);
     me = loadInput(mi->actionId);
 
@@ -834,6 +2349,11 @@ void MD_Menu::handleInput(bool bNew)
       ended = true;
     else if (nav != NAV_NULL || me->action == INP_EXT)    /// INP_EXT does not use main nav input!
     {
+#if MNU_ACCEL
+      if (((me->action == INP_INT || me->action == INP_FLOAT) && !DIGIT_EDIT(me)) || me->action == INP_ENGU)
+        incDelta = accelerate(nav, incDelta);
+#endif
+
       if (nav != NAV_NULL)  // for INP_EXT we need to set this in processExt()
         timerStart();
 
@@ -841,33 +2361,85 @@ void MD_Menu::handleInput(bool bNew)
       {
       case INP_LIST:  ended = processList(nav, me, mi->action == MNU_INPUT_FB);            break;
       case INP_BOOL:  ended = processBool(nav, me, mi->action == MNU_INPUT_FB);            break;
-      case INP_INT:   ended = processInt(nav, me, mi->action == MNU_INPUT_FB, incDelta);   break;
-      case INP_FLOAT: ended = processFloat(nav, me, mi->action == MNU_INPUT_FB, incDelta); break;
+      case INP_INT:
+#if MNU_DIGIT_EDIT
+        if (DIGIT_EDIT(me))
+          ended = processDigit(nav, me, mi->action == MNU_INPUT_FB, incDelta);
+        else
+#endif
+          ended = processInt(nav, me, mi->action == MNU_INPUT_FB, incDelta);
+        break;
+      case INP_FLOAT:
+#if MNU_DIGIT_EDIT
+        if (DIGIT_EDIT(me))
+          ended = processDigit(nav, me, mi->action == MNU_INPUT_FB, incDelta);
+        else
+#endif
+          ended = processFloat(nav, me, mi->action == MNU_INPUT_FB, incDelta);
+        break;
       case INP_ENGU:  ended = processEng(nav, me, mi->action == MNU_INPUT_FB, incDelta);   break;
-      case INP_RUN:   ended = processRun(nav, me, mi->action == MNU_INPUT_FB);             break;
+      case INP_RUN:   ended = processRun(nav, me);                                         break;
       case INP_EXT:   ended = processExt(nav, me, false, mi->action == MNU_INPUT_FB);      break;
       }
     }
+
+#if MNU_FB_RATE
+    // Send any real time feedback held back, and always the last value
+    // before the edit ends. Ending with SEL has already set the value.
+    if (TEST_FLAG(F_FBPENDING))
+    {
+      if (ended && nav == NAV_SEL)
+      {
+        CLEAR_FLAG(F_FBPENDING);
+      }
+      else if (ended || millis() - _timeFeedback >= _fbInterval)
+        feedbackSend(me);
+    }
+#endif
+
+#if MNU_ASYNC
+    if (ended && TEST_FLAG(F_ASYNCWAIT))  // the final 'set' is still in progress
+    {
+      ended = false;
+      asyncShow(me);
+    }
+#endif
   }
 
   if (ended)
   {
     CLEAR_FLAG(F_INEDIT);
-    handleMenu(true);
+    listCacheClear();
+#if MNU_STORE
+    if (_store != nullptr) _store->editEnd();
+#endif
+    _stateNext = ST_MENU;
   }
 }
 
 void MD_Menu::handleMenu(bool bNew)
 {
   bool update = false;
-  mnuItem_t *mi;
+  const mnuItem_t *mi;
 
   if (bNew)
   {
-    _cbDisp(DISP_CLEAR, nullptr);
-    _cbDisp(DISP_L0, _mnuStack[_currMenu].label);
+    CLEAR_FLAG(F_INVIRT);
+#if MNU_SEARCH
+    _srchLen = 0;
+#endif
+    display(DISP_CLEAR);
+#if MNU_STACK_COMPACT
+    memcpy_P(_lineBuf, _def->mnuHdr[_mnuStack[_currMenu].idx].label, HEADER_LABEL_SIZE + 1);
+    display(DISP_L0, _lineBuf);
+#else
+    display(DISP_L0, _mnuStack[_currMenu].label);
+#endif
     if (_mnuStack[_currMenu].idItmCurr == 0)
-      _mnuStack[_currMenu].idItmCurr = _mnuStack[_currMenu].idItmStart;
+      _mnuStack[_currMenu].idItmCurr = stackItmStart();
+#if MNU_MULTI_LINE
+    _viewTop = viewNext(stackItmStart() - 1, true);
+#endif
     SET_FLAG(F_INMENU);
     timerStart();
     update = true;
@@ -875,43 +2447,52 @@ void MD_Menu::handleMenu(bool bNew)
   else
   {
     uint16_t incDelta = 1;
-    userNavAction_t nav = _cbNav(incDelta);
+    userNavAction_t nav = getNav(incDelta);
 
     if (nav != NAV_NULL) timerStart();
+#if MNU_SEARCH
+    if (nav != NAV_NULL) _srchLen = 0;
+#endif
 
     switch (nav)
     {
     case NAV_DEC:
-      do
+      for (uint16_t i = 0; i < _navRepeat; i++)
       {
-        if (_mnuStack[_currMenu].idItmCurr > _mnuStack[_currMenu].idItmStart)
-        {
-          _mnuStack[_currMenu].idItmCurr--;
-          update = true;
-        }
-        else if (TEST_FLAG(F_MENUWRAP))
+        do
         {
-          _mnuStack[_currMenu].idItmCurr = _mnuStack[_currMenu].idItmEnd;
-          update = true;
-        }
-      } while ((mi = loadItem(_mnuStack[_currMenu].idItmCurr)) == nullptr);
+          if (_mnuStack[_currMenu].idItmCurr > stackItmStart())
+          {
+            _mnuStack[_currMenu].idItmCurr--;
+            update = true;
+          }
+          else if (TEST_FLAG(F_MENUWRAP))
+          {
+            _mnuStack[_currMenu].idItmCurr = stackItmEnd();
+            update = true;
+          }
+        } while ((mi = loadItem(_mnuStack[_currMenu].idItmCurr)) == nullptr);
+      }
       break;
 
     case NAV_INC:
-    do
-    {
-      if (_mnuStack[_currMenu].idItmCurr < _mnuStack[_currMenu].idItmEnd)
+      for (uint16_t i = 0; i < _navRepeat; i++)
       {
-        _mnuStack[_currMenu].idItmCurr++;
-        update = true;
-      }
-      else if (TEST_FLAG(F_MENUWRAP))
-      {
-        _mnuStack[_currMenu].idItmCurr = _mnuStack[_currMenu].idItmStart;
-        update = true;
+        do
+        {
+          if (_mnuStack[_currMenu].idItmCurr < stackItmEnd())
+          {
+            _mnuStack[_currMenu].idItmCurr++;
+            update = true;
+          }
+          else if (TEST_FLAG(F_MENUWRAP))
+          {
+            _mnuStack[_currMenu].idItmCurr = stackItmStart();
+            update = true;
+          }
+        } while ((mi = loadItem(_mnuStack[_currMenu].idItmCurr)) == nullptr);
       }
-    } while ((mi = loadItem(_mnuStack[_currMenu].idItmCurr)) == nullptr);
-    break;
+      break;
 
     case NAV_SEL:
       {
@@ -924,16 +2505,26 @@ void MD_Menu::handleMenu(bool bNew)
           {
             _currMenu++;
             loadMenu(mi->actionId);
-            handleMenu(true);
+            _stateNext = ST_MENU;
           }
           break;
 
         case MNU_INPUT:
         case MNU_INPUT_FB:
           if (loadInput(mi->actionId) != nullptr)
-            handleInput(true);
+            _stateNext = ST_INPUT;
           else
+          {
             MD_PRINTS("\nInput definition not found");
+          }
+          break;
+
+        case MNU_VIRTUAL:
+#if MNU_VIRTUAL_ITEMS
+          _stateNext = ST_VIRTUAL;
+#else
+          MD_PRINTS("\nVirtual items not included");
+#endif
           break;
         }
       }
@@ -947,7 +2538,7 @@ void MD_Menu::handleMenu(bool bNew)
       else
       {
         _currMenu--;
-        handleMenu(true);  // just one level of recursion;
+        _stateNext = ST_MENU;
       }
       break;
 
@@ -957,57 +2548,324 @@ void MD_Menu::handleMenu(bool bNew)
     }
   }
 
-  if (update) // update L1 on the CB_DISP
+  if (update)
+    menuUpdate(bNew);
+}
+
+void MD_Menu::menuUpdate(bool all)
+{
+  (void)all;    // only used by the item window
+#if MNU_MULTI_LINE
+  if (_dispLines > 2)
+    viewUpdate(_mnuStack[_currMenu].idItmCurr, all);
+  else // update L1 on the CB_DISP
+#endif
   {
-    mnuItem_t *mi = loadItem(_mnuStack[_currMenu].idItmCurr);
+    const mnuItem_t *mi = loadItem(_mnuStack[_currMenu].idItmCurr);
 
     if (mi != nullptr)
     {
-      char sz[strlen(mi->label) + strlen(MNU_DELIM_L) + strlen(MNU_DELIM_R) + 1]; // temporary string
+      char *p = strAppend(_lineBuf, MNU_DELIM_L);
+
+      p = strAppend(p, mi->label);
+      strAppend(p, MNU_DELIM_R);
+
+      display(DISP_L1, _lineBuf);
+    }
+  }
+}
+
+#if MNU_VIRTUAL_ITEMS
+void MD_Menu::handleVirtual(bool bNew)
+// The virtual items are displayed like a menu. The menu item that 
+// selected them stays current in the menu stack and provides the title.
+{
+  bool update = false;
+
+  if (bNew)
+  {
+    const mnuItem_t *mi = loadItem(_mnuStack[_currMenu].idItmCurr);
+
+    _virtId = mi->actionId;
+    _virtCount = virtualCount(_virtId);
+    if (_virtCount == 0)
+    {
+      MD_PRINTS("\nEmpty virtual list");
+      return;
+    }
+
+    display(DISP_CLEAR);
+    strcpy(_lineBuf, mi->label);   // never pass the callback a pointer into the menu tables
+    display(DISP_L0, _lineBuf);
+    _virtIdx = 0;
+#if MNU_MULTI_LINE
+    _viewTop = 0;
+#endif
+    SET_FLAG(F_INVIRT);
+    timerStart();
+    update = true;
+  }
+  else
+  {
+    uint16_t incDelta = 1;
+    userNavAction_t nav = getNav(incDelta);
+
+    if (nav != NAV_NULL) timerStart();
+
+    switch (nav)
+    {
+    case NAV_DEC:
+      for (uint16_t i = 0; i < _navRepeat; i++)
+      {
+        if (_virtIdx > 0)
+        {
+          _virtIdx--;
+          update = true;
+        }
+        else if (TEST_FLAG(F_MENUWRAP))
+        {
+          _virtIdx = _virtCount - 1;
+          update = true;
+        }
+      }
+      break;
+
+    case NAV_INC:
+      for (uint16_t i = 0; i < _navRepeat; i++)
+      {
+        if (_virtIdx < _virtCount - 1)
+        {
+          _virtIdx++;
+          update = true;
+        }
+        else if (TEST_FLAG(F_MENUWRAP))
+        {
+          _virtIdx = 0;
+          update = true;
+        }
+      }
+      break;
+
+    case NAV_SEL:
+      if (_cbVirt(_virtId, VIRT_SELECT, _virtIdx, nullptr, 0) != 0)
+        _stateNext = ST_MENU;
+      else
+      {
+        // the selection may have changed the collection
+        _virtCount = virtualCount(_virtId);
+        if (_virtCount == 0)
+          _stateNext = ST_MENU;
+        else
+        {
+          if (_virtIdx >= _virtCount) _virtIdx = _virtCount - 1;
+          update = true;
+        }
+      }
+      break;
+
+    case NAV_ESC:
+      _stateNext = ST_MENU;
+      break;
+
+    default:
+      // do nothing except stop compiler warnings
+      break;
+    }
+  }
+
+#if MNU_MULTI_LINE
+  if (update && _dispLines > 2)
+    viewUpdate(_virtIdx, bNew);
+  else
+#endif
+  if (update) // update L1 on the CB_DISP
+  {
+    char *p = strAppend(_lineBuf, MNU_DELIM_L);
+
+    virtualItem(_virtId, _virtIdx, p, ITEM_LABEL_SIZE + 1, false);
+    strAppend(p + strlen(p), MNU_DELIM_R);
+
+    display(DISP_L1, _lineBuf);
+  }
+}
+#endif
+
+#if MNU_MULTI_LINE
+MD_Menu::viewPos_t MD_Menu::viewNext(viewPos_t pos, bool fwd)
+// Find the next (or previous) item position in the menu being displayed.
+// Positions are the menu item ids, skipping any that are missing, or the 
+// virtual item index.
+{
+#if MNU_VIRTUAL_ITEMS
+  if (TEST_FLAG(F_INVIRT))
+  {
+    pos += (fwd ? 1 : -1);
+    return(pos < 0 || pos >= _virtCount ? -1 : pos);
+  }
+#endif
+
+  do
+  {
+    pos += (fwd ? 1 : -1);
+    if (pos < stackItmStart() || pos > stackItmEnd())
+      return(-1);
+  } while (loadItem(pos) == nullptr);
+
+  return(pos);
+}
+
+void MD_Menu::viewUpdate(viewPos_t curr, bool all)
+// Show the window of menu items in display lines 1 onwards. The window 
+// is scrolled to keep the current item visible, otherwise only the 
+// lines with the old and new current item are redrawn.
+{
+  uint8_t rows = _dispLines - 1;
+  viewPos_t pos = _viewTop;
+  uint8_t r;
+
+  // check if the current item is in the window
+  for (r = 0; r < rows && pos != -1 && pos != curr; r++)
+    pos = viewNext(pos, true);
+
+  if (pos != curr || r == rows)
+  {
+    // scroll so that the current item is at the edge of the window 
+    // nearest to where it was
+    if (curr < _viewTop)
+      _viewTop = curr;
+    else
+    {
+      _viewTop = curr;
+      for (r = 1; r < rows && (pos = viewNext(_viewTop, false)) != -1; r++)
+        _viewTop = pos;
+    }
+    all = true;
+  }
 
-      strcpy(sz, MNU_DELIM_L);
-      strcat(sz, mi->label);
-      strcat(sz, MNU_DELIM_R);
+  // now show the lines that need it
+  pos = _viewTop;
+  for (r = 0; r < rows; r++)
+  {
+    if (all || (pos != -1 && (pos == curr || pos == _viewPrev)))
+    {
+      _lineBuf[0] = '\0';
+      if (pos != -1)
+      {
+        char *p = strAppend(_lineBuf, pos == curr ? MNU_CURSOR : MNU_NOCURSOR);
+
+#if MNU_VIRTUAL_ITEMS
+        if (TEST_FLAG(F_INVIRT))
+          virtualItem(_virtId, pos, p, ITEM_LABEL_SIZE + 1, false);
+        else
+#endif
+          strAppend(p, loadItem(pos)->label);
+      }
 
-      _cbDisp(DISP_L1, sz);
+      _dispLine = r + 1;
+      _dispCol = 0;
+      display(DISP_LINE, _lineBuf);
     }
+
+    if (pos != -1) pos = viewNext(pos, true);
+  }
+
+  _viewPrev = curr;
+}
+#endif
+
+MD_Menu::menuState_t MD_Menu::stateCurrent(void)
+{
+  if (TEST_FLAG(F_INEDIT)) return(ST_INPUT);
+#if MNU_VIRTUAL_ITEMS
+  if (TEST_FLAG(F_INVIRT)) return(ST_VIRTUAL);
+#endif
+  return(ST_MENU);
+}
+
+void MD_Menu::stateEnter(void)
+// Run the entry to each state requested. An entry can itself request 
+// another state (eg, an input that ends as soon as it is started), so 
+// this loops until there are no more changes.
+{
+  while (_stateNext != ST_NONE)
+  {
+    menuState_t st = _stateNext;
+
+    _stateNext = ST_NONE;
+    (this->*_stateTbl[st])(true);
   }
 }
 
 bool MD_Menu::runMenu(bool bStart)
 {
+#if MNU_STORE
+  if (_store != nullptr) _store->run();
+#endif
+
   // check if we need to process anything
   if (!TEST_FLAG(F_INMENU) && !bStart)
   {
     uint16_t dummy;
 
-    bStart = (TEST_FLAG(F_AUTOSTART) && _cbNav(dummy) == NAV_SEL);
-    if (bStart) MD_PRINTS("\nrunMenu: Auto Start detected");
+    bStart = (TEST_FLAG(F_AUTOSTART) && getNav(dummy) == NAV_SEL);
+    if (bStart) { MD_PRINTS("\nrunMenu: Auto Start detected"); }
     if (!bStart) return(false);   // nothing to do
   }
 
+#if MNU_STATS
+  uint32_t timeStart = micros();
+  uint8_t stackMark;
+
+  _stackBase = (uintptr_t)&stackMark;
+#endif
+
   if (bStart)   // start the menu
   {
     MD_PRINTS("\nrunMenu: Starting menu");
     _currMenu = 0;
     loadMenu();
-    handleMenu(true);
+    _stateNext = ST_MENU;
+    stateEnter();
   }
   else    // keep running current menu
   {
-    if (TEST_FLAG(F_INEDIT))
-      handleInput();
-    else
-      handleMenu();
+    // Process one navigation action, or all those that are queued
+    do
+    {
+      (this->*_stateTbl[stateCurrent()])(false);
+      stateEnter();
+    }
+#if MNU_NAV_QUEUE_SIZE
+    while (_navQHead != _navQTail && TEST_FLAG(F_INMENU));
+#else
+    while (false);
+#endif
 
     timerCheck();  // check for timeout before we end here
 
     if (!TEST_FLAG(F_INMENU))
     {
-      _cbDisp(DISP_CLEAR, nullptr);
+      display(DISP_CLEAR);
+#if MNU_STORE
+      if (_store != nullptr) _store->flush();
+#endif
       MD_PRINTS("\nrunMenu: Ending Menu");
     }
   }
 
+#if MNU_FRAME
+  frameFlush();   // send the screen changes made in this pass
+#endif
+
+#if MNU_STATS
+  {
+    uint32_t t = micros() - timeStart;
+
+    _stats.runCount++;
+    if (t > _stats.runMaxTime) _stats.runMaxTime = t;
+    _stackBase = 0;
+  }
+#endif
+
   return(TEST_FLAG(F_INMENU));
 }
@@ -36,6 +36,35 @@ for what really matters.
 If you like and use this library please consider making a small donation using [PayPal](https://paypal.me/MajicDesigns/4USD)
 
 \page pageRevisionHistory Revision History
+Oct 2026 version 2.2.0
+- Added optional id lookup index tables (MNU_INDEX) built in begin().
+- Added MD_Menu_Compile.h to validate menu tables and precompile index tables at build time.
+- Pick list count and item offsets are cached for each edit session (MNU_LIST_CACHE_SIZE).
+- Added optional display diffing (MNU_DISP_DIFF, setDisplayDiff()) and DISP_SPAN display request.
+- Added optional navigation event queue (MNU_NAV_QUEUE_SIZE, postNav()) with runMenu() processing all queued events.
+- Added CMake host build with Arduino shim and scripted Menu_Host driver in extras/host.
+- Added ctest regression tests comparing Menu_Host script output with expected transcripts.
+- Added Menu_Bench benchmarks for the host build and as an example sketch.
+- Added optional activity statistics (MNU_STATS, getStats(), resetStats(), dumpStats()).
+- mnuId_t and listId_t can be widened to 16 bits (MNU_ID_BITS, MNU_LIST_BITS) for large menus.
+- Faster numeric formatting and input field display strings built without rescanning.
+- Added mnuDef_t and constructor so many menu sessions can share one menu definition.
+- MNU_STACK_SIZE can be set at compile time and the menu stack keeps only the header positions (MNU_STACK_COMPACT).
+- Added optional time based numeric input acceleration (MNU_ACCEL, setAcceleration()).
+- Added optional INP_OPT_DIGIT input option for digit by digit editing (MNU_DIGIT_EDIT) and DISP_CURSOR display request.
+- Added optional MNU_VIRTUAL menu items and virtual pick lists generated by a user callback (MNU_VIRTUAL_ITEMS, setVirtualCallback()).
+- Added optional scrolling menu item window on multi line displays (MNU_MULTI_LINE, setDisplayLines()) and DISP_LINE display request.
+- Added optional user frame buffer for the display, sent once per runMenu() (MNU_FRAME, setFrameBuffer()).
+- Menu records are accessed in place without copying (MNU_ZERO_COPY) on processors with PROGMEM in the normal address space.
+- Added optional MD_MenuStore persistent value store with batched, wear levelled writes (MNU_STORE, setStore()).
+- Added optional rate limit for real time feedback value requests (MNU_FB_RATE, setFeedbackInterval()).
+- Added optional type ahead search of the current menu (MNU_SEARCH, searchItem()) using a sorted label index.
+- Added openMenu() to start the menu at a header, item or input id, using a parent map built in begin() (MNU_PARENT_MAP).
+- Menu, input and virtual list handlers run from a table driven state machine instead of calling each other recursively.
+- Added stack high water mark to the statistics (stackMax, stackCheck()).
+- Display lines are built in one fixed size buffer shared by all objects (MNU_FIELD_WIDTH_MAX, MNU_UNITS_SIZE) instead of variable length arrays on the stack.
+- Added optional asynchronous value requests (valuePending, completeValueRequest()) for slow data sources (MNU_ASYNC).
+
 Feb 2021 version 2.1.3
 - Introduced listId_t typedef for list index related counting.
 - Implemented suggested solution for fixing negative floats between 0 and -1 (Issue #15).
@@ -129,6 +158,15 @@ cancel changes to an edited value.
 A variety of input hardware setups are demonstrated in the Test 
 example code provided.
 
+Long menus can also be navigated by typing the start of an item label on a 
+keypad or the serial port. When MNU_SEARCH is enabled, each character passed 
+to searchItem() jumps straight to the first matching item in the current menu.
+
+Frequently used settings can be reached directly (eg, from a shortcut key) 
+when MNU_PARENT_MAP is enabled. openMenu() starts the menu at a menu header, 
+menu item or input value edit, with the trail of menus back to the root 
+rebuilt so that ESC works as if the user had navigated there.
+
 Menu Display
 ------------
 Menu display is enabled by user code as a callback routine from the 
@@ -144,6 +182,18 @@ and the second as the current menu selection or currently edited value,
 as appropriate. If the display can only support one line, the first line 
 is discarded and only the second line displayed.
 
+Graphic displays that are updated by sending a whole frame (eg, by DMA) can 
+have the menu screen composed into a text frame buffer using setFrameBuffer(). 
+A frame ready callback is then called once for each change of screen, rather 
+than a display callback for every line. The frame buffer support is 
+included by defining MNU_FRAME as 1.
+
+Displays with more than two lines (eg, 4 line LCD modules or graphic OLED 
+displays) can show several menu items at once by setting the number of lines
+with setDisplayLines(). The menu items are then shown in a scrolling window 
+below the title line, with the current item marked. The item window is 
+included by defining MNU_MULTI_LINE as 1.
+
 A variety of display hardware setups are demonstrated in the Test 
 example code provided.
 
@@ -157,6 +207,107 @@ The MD_Menu library uses statically allocated data located in PROGMEM for
 the menu system and only copies the current menu record into RAM. All user 
 values reside in user code and are not duplicated in the library.
 
+On processors where PROGMEM is part of the normal address space (eg, ARM, 
+ESP32 and the host build), MNU_ZERO_COPY is enabled by default and the menu 
+records and labels are used directly from the tables, without the RAM copy. 
+Labels are still copied to a RAM line buffer before being passed to the display 
+callback, so the callback never receives a pointer into the menu tables. 
+It is disabled for AVR and ESP8266 processors, where PROGMEM needs special 
+access, and can be set to 0 to force the copying behavior on other processors.
+
+The menu, input edit and virtual list handlers are run by a small state machine 
+in runMenu() and never call each other, so the stack used by the library does 
+not depend on the depth of the menu. With MNU_STATS enabled, the stack used 
+below runMenu() is measured at every user callback and reported by getStats().
+
+Compile Time Checking
+---------------------
+Menu tables declared *constexpr* can be validated by the compiler using the 
+MD_MENU_VALIDATE() macro in MD_Menu_Compile.h. This detects duplicate ids, empty 
+or dangling header item ranges, menu items referring to undefined menus or inputs 
+and menu trees that are deeper than MNU_STACK_SIZE. The MD_MENU_INDEX() macro in 
+the same file generates the id lookup index tables into PROGMEM at build time, to 
+be passed to setIndex() when MNU_INDEX is enabled. The Menu_Host program in 
+extras/host uses both macros for its menu tables.
+
+Host Build
+----------
+The library can also be built natively on a Linux host using the CMakeLists.txt 
+file in the library folder. A minimal Arduino shim and a scripted navigation and 
+display driver (Menu_Host) are provided in the extras/host folder, so that menu 
+logic can be run and profiled without the target hardware.
+
+For a build with the default options, ctest runs a set of Menu_Host navigation 
+scripts and compares the output with the expected transcripts in extras/host/tests.
+The same build also makes Menu_Host and Menu_Bench variants with the optional 
+features (index tables, display diffing, the navigation queue, statistics, search, 
+openMenu(), the optional editing and display features, the value store, the full 
+copy menu stack, PROGMEM record copies, 16 bit ids and a shared menu definition 
+without the table constructor) compiled in. ctest runs the default scripts with 
+each variant, as the options must not change the output, and adds scripts that 
+use the options.
+
+The Menu_Bench program in extras/host times runMenu() for each keypress
+across synthetic wide, deep, pick list and numeric edit menus of increasing
+size, and reports the display and value callbacks and PROGMEM bytes read
+per keypress. The Menu_Bench example sketch runs the same timing on the 
+target hardware. MNU_ZERO_COPY is enabled by default for the host build, so 
+define it as 0 to profile the PROGMEM copying done on AVR processors.
+
+Sharing Menu Definitions
+------------------------
+Several menu sessions (eg, one for each of a number of operator panels) can run 
+the same menu by sharing one *mnuDef_t* menu definition. Each MD_Menu object 
+created with the mnuDef_t constructor holds only its own navigation state, 
+callbacks and options. The library working buffers (the display line, the record
+copies and the pick list cache) are static and shared by all the objects, so all
+the menus must be run from the same thread and one runMenu() call must finish
+before the next one starts. Each object also holds the menu definition for the 
+table based constructor. If that constructor is not used, MNU_DEF_LOCAL can be set
+to 0 to remove it and its copy of the definition from each object.
+
+Each session holds the callback pointers, the menu stack (a header position and
+the current item for each level), the value being edited and the timers, plus the 
+fields of the optional features that are compiled in. Measured on a 64 bit host 
+with the default 8 bit ids, sizeof(MD_Menu) is 136 bytes with the default options, 
+88 with MNU_DEF_LOCAL 0, and 168 when MNU_ASYNC, MNU_FB_RATE, MNU_DIGIT_EDIT, 
+MNU_VIRTUAL_ITEMS, MNU_MULTI_LINE, MNU_FRAME and MNU_ACCEL are also set to 1. 
+Setting MNU_STACK_COMPACT to 0 adds a copy of the menu header to each stack 
+level, 208 bytes with the default options. Pointers are smaller on 8 and 32 bit 
+targets, so the object is smaller there.
+
+Persistent Values
+-----------------
+Values edited with the menu are often saved in EEPROM or flash memory, but 
+writing them in the value callback for every change (especially with real-time 
+feedback) is slow and wears out the memory. The MD_MenuStore class in 
+MD_MenuStore.h holds the values for a list of input ids in RAM and writes them 
+to storage in one batch when an edit ends, after an optional delay that combines 
+a number of edits, or when the menu is exited. Each write goes to the next of a 
+number of slots in the storage area to spread the wear, and the most recent 
+valid image is loaded by begin(). The storage is accessed through a user callback, 
+for example for the AVR EEPROM
+
+    bool storeIO(bool bWrite, uint16_t addr, uint8_t *data, uint16_t len)
+    {
+      for (uint16_t i = 0; i < len; i++)
+        if (bWrite) EEPROM.update(addr + i, data[i]); else data[i] = EEPROM.read(addr + i);
+      return(true);
+    }
+
+The store is attached to the menu with setStore(), included by defining MNU_STORE 
+as 1, and the value callback for the stored inputs returns the store's valueRequest(). A file based storage callback 
+for the host build is in extras/host.
+
+Slow Data Sources
+-----------------
+Values held in other devices (eg, over I2C or Modbus) can take longer to read or 
+write than runMenu() should be blocked for. The value callback can then start the 
+transfer and return &MD_Menu::valuePending, and the user code calls 
+completeValueRequest() when the transfer is finished. The menu shows a placeholder 
+for the value while it waits, and ESC and the menu timeout still work. 
+Asynchronous requests are included by defining MNU_ASYNC as 1.
+
 Menu Management
 ---------------
 ![Data Structure Map] (Data_Structures.jpg "Data Structure Map")
@@ -170,11 +321,34 @@ all the ids in locations in between, and should be in number sequence.
 
 A menu item may lead to another menu (MNU_MENU, if it is a node in the menu tree)
 an input item (of type *mnuInput_t*) if it is a leaf of the menu system (MNU_INPUT),
-or an input item with real-time feedback (MNU_INPUT_FB) that reports the value each 
-time with every change of value. The depth of the menu tree is restricted by the 
-defined MENU_STACK_SIZE constant. When this limit is exceeded, the library will 
+an input item with real-time feedback (MNU_INPUT_FB) that reports the value each 
+time with every change of value, or a list of virtual items (MNU_VIRTUAL). The depth of the menu tree is restricted by the 
+defined MNU_STACK_SIZE constant. When this limit is exceeded, the library will 
 just ignore requests that cause additional menu depth but continues to run.
 
+Each level of the menu stack holds only the header table position and the current 
+item, and the rest of the header is read from PROGMEM when needed. This allows deep 
+menu trees (set MNU_STACK_SIZE) and many menu sessions for little RAM. Defining 
+MNU_STACK_COMPACT as 0 keeps a RAM copy of the whole menu header, including its 
+label, in each level instead, as in earlier versions of the library.
+
+Virtual items are generated at run time by a callback following the *cbVirtual* 
+prototype, set using setVirtualCallback(). Selecting a MNU_VIRTUAL menu item displays 
+a list of items, titled with the menu item label, that is navigated like a menu. The 
+callback is asked for the number of items and for the label of each item as it is 
+displayed, using the menu item actionId to identify the collection. Selecting an item 
+is reported to the callback, which decides whether the list stays displayed. ESC 
+returns to the menu. As only the current item is held by the library, collections 
+can be of any size up to the limit of listId_t without using more memory. Virtual 
+items are included by defining MNU_VIRTUAL_ITEMS as 1, otherwise MNU_VIRTUAL menu 
+items and virtual pick lists are ignored.
+
+Ids are of type *mnuId_t*, which is 8 bits by default and limits each table to 
+ids 0 to 127. Pick list indices are of type *listId_t*, limiting a list to 255 
+items. Larger menus can be built by defining MNU_ID_BITS and/or MNU_LIST_BITS as 
+16 for the library and sketch (eg, in the compiler options), at the cost of more 
+RAM and PROGMEM for the menu definitions.
+
 Menu input items define the type of value that is to be edited by the user and
 parameters associated with managing the input for that value. Before the value
 is edited a callback following the *cbValueRequest* prototype is called to 'get'
@@ -186,13 +360,16 @@ is used for editing and a second *cbValueRequest* (conceptually a 'set') is invo
 after the value is updated, enabling the user code to take action on the change. 
 If the variable edit is canceled, the second *cbValueRequest* 'set' call does not 
 occur and no further action is required from the user code. If the edit is specified 
-with real-time feedback, the value is 'set' for each change in value. 
+with real-time feedback, the value is 'set' for each change in value, or at a limited 
+rate set by setFeedbackInterval() (included if MNU_FB_RATE is defined as 1). 
 
 Variable data input may be of the following types:
 - **Pick List** specifies a PROGMEM character string with list items separated
 by the '|' character (defined as INPUT_SEPARATOR), for example "Apple|Orange|Pear".
 The list is specified as the pList parameter and the get/set value callback expects
-a value that is the index of the current selection (zero based).
+a value that is the index of the current selection (zero based). If pList is nullptr, 
+the list items are generated by the virtual item callback, with the input id 
+identifying the list.
 - **Boolean** for Input of boolean (Y/N) values. As the user makes changes, the
 value changes between displays of 'Y' and 'N' (defined as INP_BOOL_T and INP_BOOL_F).
 The get/set callback expects a 0/1 value.
@@ -221,6 +398,18 @@ user code. User code is only ever executed as part of the 'set' invocation.
 The value callback 'get' function is invoked until the value is confirmed using the normal
 method for the menu. All values are 32 bit signed integers.
 
+Integer and floating point inputs can be edited one digit at a time by setting the 
+INP_OPT_DIGIT option in the options field of the input definition. The editable digits 
+are shown with leading zeros and the position being edited is shown using the 
+DISP_CURSOR display request. INC and DEC change only the selected digit (in the number 
+base for integers, or 10 if the base is not 2 to 16), wrapping around within the digit. 
+Whole multiples of the base in incDelta carry into the higher digits. SEL moves to the 
+next lower digit and confirms the value after the last digit. If the lower bound is negative, the first position is the sign ('+' or '-'), 
+changed by INC and DEC. Values are kept within the bounds of the input specification.
+If the field is too narrow for the sign, decimal point and at least one whole digit, 
+it is widened to fit. Digit editing is included by defining MNU_DIGIT_EDIT as 1, 
+otherwise INP_OPT_DIGIT inputs are edited as a whole value.
+
 \page pageCopyright Copyright
 Copyright (C) 2017, 2020 Marco Colli. All rights reserved.
 
@@ -254,7 +443,116 @@ const uint8_t INPUT_LABEL_SIZE = 14;    ///< Displayed length of an input item l
 // Miscellaneous defines
 #define ARRAY_SIZE(a) (sizeof(a)/sizeof((a)[0]))  ///< Generic macro for obtaining number of elements of an array
 #define UOM(s)        ((s[0] << 24) + (s[1] << 16) + (s[2] << 8) + s[3])  ///< Unit of measure macro converts an engineering UOM into a 32 bit value
-const uint8_t MNU_STACK_SIZE = 4;       ///< Maximum menu 'depth'. Starting (root) menu occupies first level.
+
+#ifndef MNU_STACK_SIZE
+#define MNU_STACK_SIZE 4  ///< Maximum menu 'depth'. Starting (root) menu occupies first level.
+#endif
+
+#ifndef MNU_STACK_COMPACT
+#define MNU_STACK_COMPACT 1 ///< Set to 0 to keep a copy of the whole menu header, including the label, in each menu stack level
+#endif
+
+#ifndef MNU_NAV_QUEUE_SIZE
+#define MNU_NAV_QUEUE_SIZE 0  ///< Number of navigation events that can be queued by postNav(). Set to 0 to exclude the queue.
+#endif
+
+#ifndef MNU_DISP_DIFF
+#define MNU_DISP_DIFF 0   ///< Set to 1 to include the shadow frame buffer for display diffing (see setDisplayDiff())
+#endif
+const uint8_t MNU_DISP_WIDTH = 20;      ///< Maximum display line width tracked by the display diffing shadow frame buffer
+const uint8_t MNU_NO_CURSOR = 0xff;     ///< Display line value for no edit cursor in a frame buffer (see setFrameBuffer())
+
+#ifndef MNU_INDEX
+#define MNU_INDEX 0   ///< Set to 1 to build id lookup index tables in begin() for constant time record access
+#endif
+
+#ifndef MNU_INDEX_MAX
+#define MNU_INDEX_MAX 256 ///< Maximum number of entries in an index table built by begin(). Tables with a wider id range are scanned.
+#endif
+
+#ifndef MNU_SEARCH
+#define MNU_SEARCH 0  ///< Set to 1 to include the type ahead menu item search (see searchItem())
+#endif
+
+#ifndef MNU_PARENT_MAP
+#define MNU_PARENT_MAP 0  ///< Set to 1 to build the menu parent map in begin() and include openMenu()
+#endif
+
+#ifndef MNU_ID_BITS
+#define MNU_ID_BITS 8     ///< Size in bits of the mnuId_t type (8 or 16). 16 allows more than 127 menu headers, items and inputs.
+#endif
+
+#ifndef MNU_LIST_CACHE_SIZE
+#define MNU_LIST_CACHE_SIZE 16  ///< Number of pick list item offsets cached while a list is edited, spread evenly over longer lists. Set to 0 to exclude the cache.
+#endif
+
+#ifndef MNU_LIST_BITS
+#define MNU_LIST_BITS 8   ///< Size in bits of the listId_t type (8 or 16). 16 allows more than 255 pick list items.
+#endif
+
+#if (MNU_ID_BITS != 8 && MNU_ID_BITS != 16) || (MNU_LIST_BITS != 8 && MNU_LIST_BITS != 16)
+#error "MNU_ID_BITS and MNU_LIST_BITS must be 8 or 16"
+#endif
+
+#ifndef MNU_DEF_LOCAL
+#define MNU_DEF_LOCAL 1   ///< Set to 0 to remove the table constructor and its copy of the menu definition when all objects share an mnuDef_t
+#endif
+
+#ifndef MNU_ZERO_COPY
+#if defined(__AVR__) || defined(ESP8266)
+#define MNU_ZERO_COPY 0   ///< Set to 1 to access the menu tables directly instead of copying records from PROGMEM. Only for targets where PROGMEM is ordinary memory.
+#else
+#define MNU_ZERO_COPY 1   ///< Set to 1 to access the menu tables directly instead of copying records from PROGMEM. Only for targets where PROGMEM is ordinary memory.
+#endif
+#endif
+
+#ifndef MNU_FB_RATE
+#define MNU_FB_RATE 0 ///< Set to 1 to include the real time feedback rate limit (see setFeedbackInterval())
+#endif
+
+#ifndef MNU_ACCEL
+#define MNU_ACCEL 0   ///< Set to 1 to include the numeric input acceleration (see setAcceleration())
+#endif
+
+#ifndef MNU_FRAME
+#define MNU_FRAME 0   ///< Set to 1 to include composing the display into a user frame buffer (see setFrameBuffer())
+#endif
+
+#ifndef MNU_MULTI_LINE
+#define MNU_MULTI_LINE 0  ///< Set to 1 to include the scrolling menu item window for multi line displays (see setDisplayLines())
+#endif
+
+#ifndef MNU_VIRTUAL_ITEMS
+#define MNU_VIRTUAL_ITEMS 0 ///< Set to 1 to include MNU_VIRTUAL menu items and virtual pick lists (see setVirtualCallback())
+#endif
+
+#ifndef MNU_DIGIT_EDIT
+#define MNU_DIGIT_EDIT 0  ///< Set to 1 to include digit by digit editing (otherwise INP_OPT_DIGIT inputs are edited as a whole value)
+#endif
+
+#ifndef MNU_ASYNC
+#define MNU_ASYNC 0  ///< Set to 1 to include asynchronous value requests (see completeValueRequest())
+#endif
+
+#ifndef MNU_STORE
+#define MNU_STORE 0  ///< Set to 1 to include the persistent value store interface (see setStore())
+#endif
+
+#ifndef MNU_FIELD_WIDTH_MAX
+#define MNU_FIELD_WIDTH_MAX 12  ///< Largest input field width. Wider fields are displayed at this width.
+#endif
+
+#ifndef MNU_UNITS_SIZE
+#define MNU_UNITS_SIZE 4  ///< Largest length of the INP_ENGU units string. Longer strings are truncated.
+#endif
+
+#ifndef MNU_STATS
+#define MNU_STATS 0   ///< Set to 1 to count library hot path activity (see getStats())
+#endif
+
+#if MNU_STORE
+class MD_MenuStore;
+#endif
 
 /**
  * Core object for the MD_Menu library
@@ -273,18 +571,26 @@ public:
   * menu items, related loop variables, etc.
   * typedef this to make it easier to change to a different integer type in
   * future if required. Note that id -1 is used to indicate error or no
-  * id, so value must be signed.
+  * id, so value must be signed. The size is set by MNU_ID_BITS.
   */
+#if MNU_ID_BITS == 16
+  typedef int16_t mnuId_t;
+#else
   typedef int8_t mnuId_t;
+#endif
 
   /**
   * Common List Id type
   *
   * Common type for list counts and index values.
   * typedef this to make it easier to change to a different integer type in
-  * future if required.
+  * future if required. The size is set by MNU_LIST_BITS.
   */
+#if MNU_LIST_BITS == 16
+  typedef uint16_t listId_t;
+#else
   typedef uint8_t listId_t;
+#endif
 
   /**
   * Return values for the user input handler
@@ -328,6 +634,9 @@ public:
     DISP_CLEAR, ///< Clear the display. Message parameter is not defined
     DISP_L0,    ///< Display the data provided in line 0 (first line). For single line displays, this should be ignored.
     DISP_L1,    ///< Display the data provided in line 1 (second line). This must always be implemented.
+    DISP_SPAN,  ///< Display the data provided in line getDisplayLine() starting at column getDisplayColumn(). Only used when display diffing is enabled.
+    DISP_CURSOR,///< Show the edit cursor at line getDisplayLine() and column getDisplayColumn(). Only used for INP_OPT_DIGIT inputs.
+    DISP_LINE,  ///< Display the data provided in line getDisplayLine(), clearing the rest of the line. Only used when setDisplayLines() is more than 2.
   };
 
   /**
@@ -339,6 +648,17 @@ public:
   */
   typedef bool(*cbUserDisplay)(userDisplayAction_t action, char *msg);
 
+  /**
+  * Frame ready function prototype
+  *
+  * The user function is called when the display frame buffer set by 
+  * setFrameBuffer() has changed and should be sent to the display.
+  * The edit cursor position is available from getDisplayLine() and 
+  * getDisplayColumn(), with the line set to MNU_NO_CURSOR if no cursor 
+  * is shown.
+  */
+  typedef void(*cbFrameReady)(const char *frame);
+
   /**
   * Menu input type enumerated type specification.
   *
@@ -377,9 +697,63 @@ public:
   * When bGet is true, the function must return the pointer to the
   * data identified by the ID. Return nullptr to stop the menu from
   * editing the value.
+  * If the value cannot be obtained or saved straight away (eg, from a slow
+  * device), return &MD_Menu::valuePending and call completeValueRequest()
+  * when the request has been completed (needs MNU_ASYNC).
   */
   typedef value_t*(*cbValueRequest)(mnuId_t id, bool bGet);
 
+  /**
+  * Request values for the virtual item callback
+  *
+  * The virtual item callback will receive requests that tell it what
+  * information is needed for the virtual items being displayed.
+  */
+  enum virtualRequest_t
+  {
+    VIRT_COUNT,  ///< Return the number of items. The idx and buf parameters are not used.
+    VIRT_LABEL,  ///< Copy the label for item idx into buf, size bufLen including the '\0'. The return value is not used.
+    VIRT_SELECT, ///< Item idx was selected. Return 0 to stay in the list, anything else to return to the menu.
+  };
+
+  /**
+  * Virtual item function prototype
+  *
+  * This user function provides the items for menu items of type MNU_VIRTUAL
+  * and pick lists defined with a nullptr pList. The items are generated on 
+  * demand by their zero based index, so collections of any size, known only 
+  * at run time (eg, files on an SD card or discovered sensors) use no 
+  * library memory. The id is the actionId of the MNU_VIRTUAL menu item or 
+  * the id of the input field.
+  */
+  typedef listId_t(*cbVirtual)(mnuId_t id, virtualRequest_t req, listId_t idx, char *buf, uint8_t bufLen);
+
+#if MNU_PARENT_MAP
+  /**
+  * Menu open targets
+  *
+  * Specifies the type of record identified by the id passed to openMenu().
+  */
+  enum openTarget_t
+  {
+    OPEN_MENU,   ///< Open a menu header, with its first item current
+    OPEN_ITEM,   ///< Open the menu containing a menu item, with that item current
+    OPEN_INPUT,  ///< Open the menu item that edits an input and start editing the value
+  };
+#endif
+
+  /**
+  * Input field options
+  *
+  * Options for an input field, combined (ORed) in the options field of 
+  * the input definition.
+  */
+  enum inputOption_t
+  {
+    INP_OPT_NONE = 0x00,  ///< No options
+    INP_OPT_DIGIT = 0x01, ///< INP_INT and INP_FLOAT values are edited one digit at a time
+  };
+
   /**
   * Input field definition
   *
@@ -393,10 +767,11 @@ public:
     char    label[INPUT_LABEL_SIZE + 1]; ///< Label for this menu item
     inputAction_t action;  ///< Type of action required for this value
     cbValueRequest cbVR;   ///< Callback function to get/set the value
-    uint8_t fieldWidth;    ///< Width of the displayed field between delimiters
+    uint8_t fieldWidth;    ///< Width of the displayed field between delimiters, up to MNU_FIELD_WIDTH_MAX
     value_t range[2];      ///< definition for min/max for input range at [0]/[1]
     uint8_t base;          ///< number base for display (2 through 16) or floating increment in 1/100 units
     const char *pList;     ///< pointer to list string or engineering units string in PROGMEM
+    uint8_t options;       ///< inputOption_t options for the field, 0 if none. Zero if left out of an initializer, but compilers may warn (-Wmissing-field-initializers).
   };
 
   /**
@@ -410,6 +785,7 @@ public:
     MNU_MENU,     ///< The item is for selection of a new menu
     MNU_INPUT,    ///< The item is for input of a value
     MNU_INPUT_FB, ///< The item is for input with real time feedback of value changes
+    MNU_VIRTUAL,  ///< The item is for selection from a list of items generated by the virtual item callback
   };
 
   /**
@@ -443,6 +819,77 @@ public:
     mnuId_t idItmCurr;   ///< Current item being processed
   };
 
+#if MNU_INDEX
+  /**
+  * Id lookup index table
+  *
+  * Dense table of record positions in a menu data table, indexed by (id - idMin).
+  * Positions for ids not found in the table are set to -1. The tables are either 
+  * built in RAM by begin() or precompiled into PROGMEM (see MD_Menu_Compile.h) 
+  * and supplied using setIndex(). Only the tables built by begin() are released 
+  * by the library.
+  */
+  struct mnuIndex_t
+  {
+    const mnuId_t *pos; ///< table of positions, nullptr if not built
+    mnuId_t idMin;      ///< lowest id in the menu data table
+    uint16_t size;      ///< number of elements in pos[]
+    bool inProgmem;     ///< true if pos[] is located in PROGMEM
+    bool allocated;     ///< true if pos[] was allocated by begin(), false for tables supplied by setIndex()
+  };
+#endif
+
+  /**
+  * Menu definition
+  *
+  * Collects the menu data tables, and the lookup indices if enabled, into one
+  * structure that can be shared by many MD_Menu objects. The data tables are
+  * never changed by the library. When MNU_INDEX is enabled, the indices are built 
+  * into the shared definition by the first begin() called for any of the objects 
+  * using it, or can be set with setIndex(). The index fields can be left out of 
+  * an initializer list.
+  */
+  struct mnuDef_t
+  {
+    const mnuHeader_t *mnuHdr;  ///< Menu header table
+    mnuId_t mnuHdrCount;        ///< Number of items in the header table
+    const mnuItem_t *mnuItm;    ///< Menu item table
+    mnuId_t mnuItmCount;        ///< Number of items in the item table
+    const mnuInput_t *mnuInp;   ///< Input item table
+    mnuId_t mnuInpCount;        ///< Number of items in the input table
+#if MNU_INDEX
+    mnuIndex_t idxHdr;          ///< Index for the header table
+    mnuIndex_t idxItm;          ///< Index for the item table
+    mnuIndex_t idxInp;          ///< Index for the input table
+#endif
+#if MNU_SEARCH
+    const mnuId_t *srchItm;     ///< Item table positions sorted by label and id, nullptr if not built
+#endif
+#if MNU_PARENT_MAP
+    const mnuId_t *parentMap;   ///< Menu tree parent map (see openMenu()), nullptr if not built
+#endif
+  };
+
+#if MNU_STATS
+  /**
+  * Library activity statistics
+  *
+  * Counters accumulated since the object was created or resetStats() was 
+  * last called. Returned by getStats().
+  */
+  struct stats_t
+  {
+    uint32_t lookups;    ///< number of menu header, item and input table lookups
+    uint32_t scanned;    ///< number of table records examined (copied from PROGMEM unless MNU_ZERO_COPY) by lookups
+    uint32_t display;    ///< number of calls to the user display callback
+    uint32_t valueGet;   ///< number of cbVR get value requests
+    uint32_t valueSet;   ///< number of cbVR set value requests
+    uint32_t runCount;   ///< number of runMenu() calls that processed the menu
+    uint32_t runMaxTime; ///< longest runMenu() processing time in microseconds
+    uint16_t stackMax;   ///< most stack used in bytes below runMenu(), measured at the user callbacks and stackCheck()
+  };
+#endif
+
   /** @} */
   //--------------------------------------------------------------
   /** \name Class constructor and destructor.
@@ -464,10 +911,29 @@ public:
    * \param mnuInp  address of the input definitions data table
    * \param mnuInpCount number of elements in the input definitions table
    */
+#if MNU_DEF_LOCAL
   MD_Menu(cbUserNav cbNav, cbUserDisplay cbDisp,
     const mnuHeader_t *mnuHdr, mnuId_t mnuHdrCount,
     const mnuItem_t *mnuItm, mnuId_t mnuItmCount,
     const mnuInput_t *mnuInp, mnuId_t mnuInpCount);
+#endif
+
+  /**
+   * Class Constructor for a shared menu definition.
+   *
+   * Instantiate a new instance of the class using a menu definition that can be
+   * shared with other instances. Each object only holds the state of its own menu 
+   * session (eg, one per operator panel), so many sessions can run the same menu.
+   * The definition must exist for the life of the object.
+   *
+   * All objects share the library internal working buffers, so the menus must be 
+   * run from one thread (eg, the Arduino loop()). 
+   *
+   * \param cbNav   navigation user callback function
+   * \param cbDisp  display user callback function
+   * \param def     the menu definition
+   */
+  MD_Menu(cbUserNav cbNav, cbUserDisplay cbDisp, mnuDef_t &def);
 
   /**
    * Class Destructor.
@@ -475,7 +941,16 @@ public:
    * Released allocated memory and does the necessary to clean up once the queue is
    * no longer required.
    */
-  ~MD_Menu(void) {};
+  ~MD_Menu(void);
+
+  /**
+   * Objects cannot be copied.
+   *
+   * The object owns the indices it builds in begin(), and a copy would release 
+   * them a second time.
+   */
+  MD_Menu(const MD_Menu &) = delete;
+  MD_Menu &operator=(const MD_Menu &) = delete; ///< Objects cannot be assigned
 
   /** @} */
   //--------------------------------------------------------------
@@ -487,8 +962,19 @@ public:
   *
   * Initialize the object data. This needs to be called during setup() to initialize new
   * data for the class that cannot be done during the object creation.
+  *
+  * If MNU_INDEX is enabled, the id lookup index tables for the menu headers, items 
+  * and inputs are built here. Each index table is a dense array of record positions 
+  * covering the range of ids in use, so lookups are constant time and copy exactly one 
+  * record from PROGMEM. If the id range of a table is wider than MNU_INDEX_MAX or the 
+  * memory cannot be allocated the library falls back to sequentially scanning that table.
+  *
+  * If MNU_SEARCH is enabled, the item table positions sorted by label and id are also built
+  * here for searchItem().
+  *
+  * If MNU_PARENT_MAP is enabled, the menu tree parent map for openMenu() is built here.
   */
-  void begin(void) {};
+  void begin(void);
 
   /**
    * Run the menu.
@@ -506,6 +992,74 @@ public:
    */
   bool runMenu(bool bStart = false);
 
+#if MNU_PARENT_MAP
+  /**
+   * Open the menu at a specific menu, item or input.
+   *
+   * Start (or restart) the menu directly at a menu header, a menu item or an 
+   * input value edit, as an alternative to runMenu(true) starting at the root 
+   * menu. The menu stack is filled with the trail of menus from the root, each 
+   * with the item leading to the next menu current, so that ESC backs up the 
+   * tree as if the menu had been navigated by the user. Any menu or edit that 
+   * is running is abandoned. runMenu() is then called as normal.
+   *
+   * The trail is found in the parent map built by begin(), which holds the parent 
+   * of each menu header, the menu holding each item and the item that edits each 
+   * input. The target record is found using the id lookup index if MNU_INDEX is 
+   * enabled, otherwise by scanning its table, and following the trail back to the 
+   * root then depends only on the depth of the menu. The first path found through 
+   * the tables is used if a menu or input can be reached from more than one item. 
+   * The first menu header is always the root.
+   *
+   * \param id     the id of the menu header, menu item or input to open.
+   * \param target the type of record identified by the id, one of the openTarget_t values.
+   * \return true if the menu was opened, false if the id is not reachable from the 
+   * root menu or the trail is deeper than MNU_STACK_SIZE.
+   */
+  bool openMenu(mnuId_t id, openTarget_t target);
+#endif
+
+#if MNU_NAV_QUEUE_SIZE
+  /**
+   * Post a navigation event.
+   *
+   * Add a navigation event to the input queue, as an alternative to the library 
+   * polling the user navigation callback. This is safe to call from an interrupt 
+   * service routine (eg, a rotary encoder interrupt), as long as there is only one
+   * source of events. The next call to runMenu() processes all the queued events,
+   * with consecutive NAV_INC or NAV_DEC events combined into a single change so 
+   * that the display is only updated once.
+   * The user navigation callback is not called when the queue contains events.
+   *
+   * \param nav      the navigation action.
+   * \param incDelta the increment for the action, as for the cbUserNav callback (default 1).
+   * \return true if the event was queued, false if the queue is full.
+   */
+  bool postNav(userNavAction_t nav, uint16_t incDelta = 1);
+#endif
+
+#if MNU_SEARCH
+  /**
+   * Type ahead search of the current menu.
+   *
+   * Add a character typed by the user (eg, from a keypad or the serial port) to 
+   * the search string and make the first item in the current menu with a label 
+   * starting with the search string the current item. The comparison ignores case 
+   * and the first match is in label order. A character that leaves no match is 
+   * ignored, so the current item does not change. The search string is cleared by 
+   * any other navigation and when a new menu is displayed.
+   *
+   * The search uses the sorted label index built by begin(), or a sequential scan of 
+   * the current menu items if the index could not be allocated. The search is only 
+   * active while a menu is displayed, not while a value is edited or in a virtual list.
+   * With a frame buffer, the changed frame is sent at the next call to runMenu().
+   *
+   * \param c the character typed, '\b' to remove the last character or '\0' to clear the search string.
+   * \return true if an item matches the search string, false otherwise.
+   */
+  bool searchItem(char c);
+#endif
+
   /**
   * Check if library is running a menu.
   *
@@ -524,6 +1078,35 @@ public:
   */
   bool isInEdit(void);
 
+#if MNU_ASYNC
+  /**
+  * Complete an asynchronous value request.
+  *
+  * When the cbValueRequest callback returns &MD_Menu::valuePending, the 
+  * library shows INP_PENDING ("...") in place of the value and keeps 
+  * running until this method is called with the outcome of the request. 
+  * While waiting, ESC abandons the edit and the other navigation actions 
+  * are ignored. Menu timeouts still apply.
+  *
+  * For a 'get' request, pValue is the pointer the callback would have returned, 
+  * or nullptr to stop the edit, and the edit then starts with the value. 
+  * For a 'set' request, the edit ends when the request is completed and pValue 
+  * is not used. Real time feedback 'set' requests and INP_EXT 'get' requests 
+  * are not waited for. The edit continues and the INP_EXT value is updated 
+  * when the request is completed.
+  *
+  * This must be called from the same thread as runMenu() (eg, from loop()
+  * when the device has replied), or from within the callback itself.
+  *
+  * \param id     the id of the input passed to the callback.
+  * \param pValue pointer to the value for a 'get' request.
+  * \return true if the id matches the request being waited for, false otherwise.
+  */
+  bool completeValueRequest(mnuId_t id, value_t *pValue);
+
+  static value_t valuePending;  ///< Return the address of this value from cbValueRequest to complete the request later.
+#endif
+
   /** @} */
   //--------------------------------------------------------------
   /** \name Support methods.
@@ -573,7 +1156,136 @@ public:
   * \param t the timeout time in milliseconds, 0 to disable (default)
   */
   void setTimeout(uint32_t t);
+
+#if MNU_FB_RATE
+  /**
+  * Set the real time feedback interval.
+  *
+  * Limit the rate of the value 'set' requests for MNU_INPUT_FB inputs. When 
+  * the value changes again less than interval milliseconds after the last 
+  * request, the request is held back and only the latest value is sent once 
+  * the interval has passed, even if there is no further input. Any value held 
+  * back is sent before the edit ends, so the last value is always set.
+  * Default is to send every change.
+  *
+  * \param interval the minimum time between requests in milliseconds, 0 to send every change (default).
+  */
+  void setFeedbackInterval(uint16_t interval);
+#endif
+
+#if MNU_ACCEL
+  /**
+  * Set the numeric input acceleration.
+  *
+  * When acceleration is enabled, the increment for INP_INT, INP_FLOAT and INP_ENGU 
+  * values grows the longer the user keeps changing the value quickly in the same 
+  * direction. Navigation events less than interval milliseconds apart are counted
+  * as fast. After each count consecutive fast events the increment is multiplied
+  * by the next step in the acceleration table (x10, x100, x1000). Slowing down, 
+  * changing direction or starting a new edit returns to the normal increment.
+  * Accelerated changes stop at the end of the value range rather than wrapping
+  * around. The multiplier is applied to the incDelta from the navigation callback.
+  * Default is no acceleration. Only included when MNU_ACCEL is set to 1.
+  *
+  * \param interval the maximum time between fast events in milliseconds, 0 to disable (default).
+  * \param count    the number of consecutive fast events for each increase in the multiplier.
+  */
+  void setAcceleration(uint16_t interval, uint8_t count = 5);
+#endif
+
+#if MNU_DISP_DIFF
+  /**
+  * Set the display diffing option.
+  *
+  * When set on, the library keeps a shadow copy of the text last sent to each 
+  * display line. Line updates are compared to the shadow and only the span of 
+  * changed columns is sent to the display callback as a DISP_SPAN request, 
+  * with the line and starting column available from getDisplayLine() and 
+  * getDisplayColumn(). Characters no longer covered by a shorter line are 
+  * overwritten with spaces. Intermediate display clears while the menu is 
+  * running are not sent, as the line differences take care of them. Lines 
+  * longer than MNU_DISP_WIDTH are always sent in full as DISP_L0/DISP_L1.
+  * Default is set to no diffing.
+  *
+  * \param bSet true to set the option, false to un-set the option (default)
+  */
+  void setDisplayDiff(bool bSet);
+#endif
+
+#if MNU_FRAME
+  /**
+  * Set a frame buffer for the display.
+  *
+  * For graphic displays that are updated by sending the whole frame, the 
+  * display requests can be composed into a text frame buffer supplied by 
+  * the user code instead of being sent to the user display callback. At 
+  * the end of each runMenu() call that changed the display, the frame ready 
+  * callback is called once with the buffer, so the display can be updated 
+  * in one transfer.
+  *
+  * The buffer holds lines rows of cols characters, each row followed by a 
+  * '\0', so it must be at least lines * (cols + 1) characters long. Rows 
+  * are padded with spaces and longer messages are truncated. Row 0 is the 
+  * DISP_L0 line and row 1 the DISP_L1 line, except for a frame of one line 
+  * which only holds DISP_L1. Display diffing is not used with a frame buffer.
+  *
+  * \param frame   pointer to the frame buffer, nullptr to send requests to the display callback (default).
+  * \param lines   the number of lines in the frame.
+  * \param cols    the number of columns in the frame.
+  * \param cbFrame the frame ready callback function.
+  */
+  void setFrameBuffer(char *frame, uint8_t lines, uint8_t cols, cbFrameReady cbFrame);
+#endif
+
+#if MNU_MULTI_LINE
+  /**
+  * Set the number of display lines.
+  *
+  * By default the menu uses 2 display lines, the menu title and the current 
+  * menu item. For displays with more lines, setting the number of lines shows 
+  * a window of lines-1 menu items below the title, with the current item 
+  * marked by MNU_CURSOR. The items are sent as DISP_LINE requests, with the 
+  * line number available from getDisplayLine(). Moving within the window only 
+  * redraws the two lines where the marker changed, and the whole window is 
+  * redrawn only when it scrolls. Value editing is unchanged and uses 
+  * the first 2 lines.
+  *
+  * \param lines the number of display lines (default 2).
+  */
+  void setDisplayLines(uint8_t lines);
+#endif
+
+  /**
+  * Get the display line for a DISP_SPAN, DISP_CURSOR or DISP_LINE request.
+  *
+  * \return the line number, 0 for the first line.
+  */
+  uint8_t getDisplayLine(void) { return(_dispLine); }
+
+  /**
+  * Get the display column for a DISP_SPAN or DISP_CURSOR request.
+  *
+  * \return the starting column number, 0 for the first column.
+  */
+  uint8_t getDisplayColumn(void) { return(_dispCol); }
   
+#if MNU_STORE
+  /**
+  * Set the persistent value store.
+  *
+  * Attach a MD_MenuStore object that holds input values in RAM and saves 
+  * them to non-volatile memory. The menu tells the store when each edit
+  * ends and when the menu is exited, so that changed values are written 
+  * in one batch rather than by the value callback for every change. The 
+  * input value callbacks for the stored values should return the store 
+  * valueRequest(). Default is no store. Only included when MNU_STORE is 
+  * set to 1.
+  *
+  * \param store pointer to the store object, nullptr for no store.
+  */
+  void setStore(MD_MenuStore *store) { _store = store; }
+#endif
+
   /**
   * Set the user navigation callback function.
   *
@@ -592,6 +1304,79 @@ public:
   */
   void setUserDisplayCallback(cbUserDisplay cbDisp);
 
+#if MNU_VIRTUAL_ITEMS
+  /**
+  * Set the virtual item callback function.
+  *
+  * Set the callback function that provides the items for MNU_VIRTUAL menu 
+  * items and virtual pick lists. Default is no callback, which disables 
+  * virtual items.
+  *
+  * \param cbVirt the callback function pointer.
+  */
+  void setVirtualCallback(cbVirtual cbVirt);
+#endif
+
+#if MNU_INDEX
+  /**
+  * Set precompiled id lookup index tables.
+  *
+  * Use the index tables supplied instead of building them in RAM during begin().
+  * The tables are normally generated and validated at compile time using the
+  * MD_MENU_INDEX() macro defined in MD_Menu_Compile.h, but can also be in RAM. 
+  * Any index tables previously built by begin() are released. The tables supplied
+  * are never released by the library, so they must exist for the life of the menu 
+  * definition. The tables are set in the menu definition, so they are used by all 
+  * the objects sharing it.
+  *
+  * \param idxHdr index for the menu header table.
+  * \param idxItm index for the menu item table.
+  * \param idxInp index for the input definitions table.
+  */
+  void setIndex(const mnuIndex_t &idxHdr, const mnuIndex_t &idxItm, const mnuIndex_t &idxInp);
+#endif
+
+#if MNU_STATS
+  /**
+  * Get the library activity statistics.
+  *
+  * The statistics count the work done in the library hot paths, for 
+  * profiling menu definitions and user callbacks in the field.
+  *
+  * \return reference to the current statistics.
+  */
+  const stats_t &getStats(void) { return(_stats); }
+
+  /**
+  * Reset the library activity statistics.
+  *
+  * All the counters are set to zero.
+  */
+  void resetStats(void);
+
+  /**
+  * Print the library activity statistics.
+  *
+  * Print a one line summary of the statistics to the specified output 
+  * (eg, Serial).
+  *
+  * \param out the Print object for the output.
+  */
+  void dumpStats(Print &out);
+
+  /**
+  * Measure the stack used.
+  *
+  * Update the stackMax statistic with the stack used between the runMenu() 
+  * call and the point where this is called. The library measures the stack 
+  * each time it calls a user callback. User callback functions can also call 
+  * this method to include the stack they use in the measurement. Nothing is 
+  * measured when called from outside runMenu(). Assumes that the stack grows 
+  * downwards in memory, as it does on all the supported processors.
+  */
+  void stackCheck(void);
+#endif
+
   /** @} */
   //--------------------------------------------------------------
   /** \name List utility methods.
@@ -627,53 +1412,248 @@ private:
   // initialisation parameters and data tables
   cbUserNav _cbNav;       ///< User navigation function
   cbUserDisplay _cbDisp;  ///< User display function
-
-  const mnuHeader_t *_mnuHdr; ///< Menu header table
-  mnuId_t _mnuHdrCount;       ///< Number of items in the header table
-  const mnuItem_t *_mnuItm;   ///< Menu item table
-  mnuId_t _mnuItmCount;       ///< Number of items in the item table
-  const mnuInput_t *_mnuInp;  ///< Input item table
-  mnuId_t _mnuInpCount;       ///< Number of items in the input table
+#if MNU_VIRTUAL_ITEMS
+  cbVirtual _cbVirt;      ///< User virtual item function
+#endif
+#if MNU_STORE
+  MD_MenuStore *_store;   ///< Persistent value store, nullptr if not used
+#endif
+
+  mnuDef_t *_def;         ///< Menu definition tables and indices
+#if MNU_DEF_LOCAL
+  mnuDef_t _defLocal;     ///< Menu definition for the table constructor
+#endif
 
   // Timeout related
   uint32_t _timeLastKey;  ///< Time a menu key was last pressed
   uint32_t _timeout;      ///< Menu inactivity timeout in milliseconds
 
   // Status values and global flags
-  uint8_t _options;       ///< bit field for options and flags
+  uint16_t _options;      ///< bit field for options and flags
+
+#if MNU_DISP_DIFF
+  // Display diffing shadow frame buffer
+  char    _dispShadow[2][MNU_DISP_WIDTH + 1]; ///< Text last sent to each line
+  bool    _dispValid[2];  ///< true if the shadow for the line matches the display
+#endif
+  uint8_t _dispLine;      ///< Line for the current DISP_SPAN request
+  uint8_t _dispCol;       ///< Starting column for the current DISP_SPAN request
+
+#if MNU_FRAME
+  // Display frame buffer
+  char    *_frame;        ///< User frame buffer, nullptr if not used
+  uint8_t _frameLines;    ///< Number of lines in the frame buffer
+  uint8_t _frameCols;     ///< Number of columns in each frame buffer line
+  uint8_t _frameCurLine;  ///< Edit cursor line in the frame, MNU_NO_CURSOR if not shown
+  uint8_t _frameCurCol;   ///< Edit cursor column in the frame
+  cbFrameReady _cbFrame;  ///< User frame ready function
+#endif
+
+#if MNU_MULTI_LINE
+  // Multi line menu item window
+#if MNU_ID_BITS == 8 && MNU_LIST_BITS == 8
+  typedef int16_t viewPos_t;  ///< Item window position, a menu item id or virtual item index, -1 if none
+#else
+  typedef int32_t viewPos_t;  ///< Item window position, a menu item id or virtual item index, -1 if none
+#endif
+  uint8_t   _dispLines;   ///< Number of display lines
+  viewPos_t _viewTop;     ///< Item shown in the first line of the item window
+  viewPos_t _viewPrev;    ///< Item marked as current when the window was last shown
+#endif
+
+#if MNU_NAV_QUEUE_SIZE
+  // Navigation event queue, single producer (eg, ISR) and single consumer (runMenu)
+  volatile uint8_t _navQAction[MNU_NAV_QUEUE_SIZE]; ///< Queued navigation actions
+  volatile uint16_t _navQDelta[MNU_NAV_QUEUE_SIZE]; ///< Queued increments for the actions
+  volatile uint8_t _navQHead;   ///< Queue position for the next posted event, only changed by postNav()
+  volatile uint8_t _navQTail;   ///< Queue position for the next event to process, only changed by getNav()
+#endif
+  uint16_t _navRepeat;  ///< Number of INC/DEC events combined into the current navigation action
+
+#if MNU_ACCEL
+  // Numeric input acceleration
+  uint16_t _accelInterval;  ///< Maximum time between fast navigation events, 0 if disabled
+  uint8_t  _accelCount;     ///< Number of fast events for each acceleration step
+  uint8_t  _accelRun;       ///< Number of consecutive fast events in the same direction
+  uint8_t  _accelNav;       ///< Direction of the last navigation event
+  uint16_t _accelMult;      ///< Current increment multiplier
+#endif
+
+#if MNU_FB_RATE
+  // Real time feedback rate limit
+  uint16_t _fbInterval;     ///< Minimum time between feedback set requests, 0 if not limited
+  uint32_t _timeFeedback;   ///< Time of the last feedback set request
+#endif
+
+#if MNU_DIGIT_EDIT
+  uint8_t  _digitPos;       ///< Digit being edited for INP_OPT_DIGIT inputs, 0 for the least significant
+#endif
+
+#if MNU_VIRTUAL_ITEMS
+  // Virtual menu being displayed
+  mnuId_t  _virtId;         ///< Id passed to the virtual item callback
+  listId_t _virtIdx;        ///< Current virtual item
+  listId_t _virtCount;      ///< Number of virtual items
+#endif
 
   // Input editing buffers
   value_t *_pValue;  ///< Pointer to the user provided data buffer
   value_t _V;        ///< Copy of the value being edited
 
+#if MNU_ASYNC
+  // Asynchronous value request
+  mnuId_t  _asyncId;     ///< Input id of the request that can be completed, -1 if none
+  bool     _asyncDone;   ///< The request has been completed
+  value_t *_asyncValue;  ///< Value pointer supplied when the request was completed
+#endif
+
+  // Pick list cache for the current edit session
+  listId_t _listCount;  ///< Number of items in the list being edited
+#if MNU_LIST_CACHE_SIZE
+  static uint16_t _listOfs[MNU_LIST_CACHE_SIZE]; ///< Offset of every _listStep'th list item in the PROGMEM string, shared by all objects
+  static listId_t _listStep;                     ///< Number of list items between cached offsets
+  static const MD_Menu *_listOwner;              ///< Object whose list offsets are cached, nullptr if none
+#endif
+
+#if MNU_SEARCH
+  // Type ahead search
+  char    _srch[ITEM_LABEL_SIZE + 1]; ///< Search string typed so far
+  uint8_t _srchLen;     ///< Length of the search string
+#endif
+
+
+#if MNU_STATS
+  stats_t _stats;       ///< Library activity statistics
+  uintptr_t _stackBase; ///< Stack address at the start of runMenu(), 0 when not running
+#endif
+
+  /**
+  * Menu states
+  *
+  * The menu is always in one of the states handled by the functions in
+  * the state table, selected by the flags. A handler requests a change
+  * of state by setting the next state, and the entry to the new state is
+  * run when the handler returns, so the handlers never call each other.
+  */
+  enum menuState_t
+  {
+    ST_MENU,     ///< Menu displayed, handleMenu()
+    ST_INPUT,    ///< Input value edit, handleInput()
+#if MNU_VIRTUAL_ITEMS
+    ST_VIRTUAL,  ///< Virtual list displayed, handleVirtual()
+#endif
+    ST_NONE,     ///< No state change requested
+  };
+
+  typedef void (MD_Menu::*stateHandler_t)(bool bNew); ///< State handler function, bNew is true on entry to the state
+  static const stateHandler_t _stateTbl[ST_NONE];   ///< State handler for each state
+  menuState_t _stateNext;   ///< State to enter when the current handler returns, ST_NONE for no change
+
   // static buffers for find functions, keep accessible copies of data in PROGMEM
   mnuId_t     _currMenu;                ///< Index of current menu displayed in the stack
-  mnuHeader_t _mnuStack[MNU_STACK_SIZE];///< Stacked trail of menus being executed
-  mnuInput_t  _mnuBufInput;             ///< menu input buffer for load function
-  mnuItem_t   _mnuBufItem;              ///< menu item buffer for load function
+#if MNU_STACK_COMPACT
+  /**
+  * Compact menu stack entry
+  *
+  * The rest of the menu header is read from PROGMEM when it is needed.
+  */
+  struct mnuStack_t
+  {
+    mnuId_t idx;        ///< Position of the menu header in the header table
+    mnuId_t idItmCurr;  ///< Current item being processed
+  };
+#else
+  typedef mnuHeader_t mnuStack_t; ///< Menu stack entry is a copy of the menu header
+#endif
+  mnuStack_t  _mnuStack[MNU_STACK_SIZE];///< Stacked trail of menus being executed
+  static char _lineBuf[];               ///< display line buffer, shared by all objects. Sized in MD_Menu_lib.h
+#if !MNU_ZERO_COPY
+  static mnuInput_t _mnuBufInput;       ///< menu input buffer for load function, shared by all objects
+  static mnuItem_t  _mnuBufItem;        ///< menu item buffer for load function, shared by all objects
+#endif
 
   // Private functions
+#if MNU_INDEX
+  void       buildIndex(mnuIndex_t &idx, const void *tbl, mnuId_t count, size_t recSize); ///< build a lookup index for a PROGMEM table
+  void       freeIndex(mnuIndex_t &idx);  ///< release the memory allocated to a lookup index
+  mnuId_t    lookupIndex(const mnuIndex_t &idx, mnuId_t id); ///< return the table position for the ID or -1 if not found
+#endif
+#if MNU_SEARCH
+  void       buildSearch(void);           ///< build the item table positions sorted by label and id
+  void       searchSift(mnuId_t *srch, mnuId_t root, mnuId_t count); ///< heap sort step for buildSearch()
+  bool       searchLess(mnuId_t a, mnuId_t b); ///< true if the item at table position a sorts before the item at b
+  int        searchCompare(const char *s, mnuId_t pos, uint8_t len); ///< compare a string with the start of the label of the item at a table position
+  mnuId_t    searchId(mnuId_t k);         ///< id of the item at position k of the sorted index
+  mnuId_t    searchFind(void);            ///< find the first item in the current menu matching the search string, -1 if none
+#endif
+#if MNU_PARENT_MAP
+  mnuId_t    tablePos(const void *tbl, mnuId_t count, size_t recSize, mnuId_t id); ///< position of the record with the id in a PROGMEM table, -1 if not found
+  mnuId_t    recordPos(openTarget_t tbl, mnuId_t id); ///< position of the record in the header, item or input table, -1 if not found
+  void       buildParentMap(void);        ///< build the menu tree parent map
+#endif
   void       loadMenu(mnuId_t id = -1);   ///< find the menu header with the specified ID
-  mnuItem_t  *loadItem(mnuId_t id);       ///< find the menu item with the specified ID
-  mnuInput_t *loadInput(mnuId_t id);      ///< find the input item with the specified ID
-  void       strPreamble(char *psz, mnuInput_t *mInp);  ///< format a preamble to the a variable display
-  void       strPostamble(char *psz, mnuInput_t *mInp); ///< attach a postamble to a variable display
-  char       *ltostr(char* buf, uint8_t bufLen, int32_t v, uint8_t base, bool sign, bool leadZero = false); ///< convert long to string
+  void       stackLoad(mnuId_t idx);      ///< load the menu header at a table position to the current stack position
+  mnuId_t    stackItmStart(void);         ///< start item id of the current menu in the stack
+  mnuId_t    stackItmEnd(void);           ///< end item id of the current menu in the stack
+  const mnuItem_t  *loadItem(mnuId_t id);   ///< find the menu item with the specified ID
+  const mnuInput_t *loadInput(mnuId_t id);  ///< find the input item with the specified ID
+  char       *strAppend(char *psz, const char *s);      ///< copy a string and return a pointer to its end
+  char       *strPreamble(char *psz, const mnuInput_t *mInp);  ///< format a preamble to the a variable display, return a pointer to its end
+  char       *strPostamble(char *psz);  ///< attach a postamble to a variable display, return a pointer to its end
+  uint8_t    fieldWidth(const mnuInput_t *mInp) { return(mInp->fieldWidth > MNU_FIELD_WIDTH_MAX ? MNU_FIELD_WIDTH_MAX : mInp->fieldWidth); } ///< displayed width of an input field
+  listId_t   listCacheBuild(const char *p); ///< count the list items and cache the offset of each item
+  void       listCacheClear(void);          ///< invalidate the list cache
+  char       *listCacheItem(const char *p, listId_t idx, char *buf, uint8_t bufLen); ///< get a list item using the cache, if available
+#if MNU_VIRTUAL_ITEMS
+  listId_t   virtualCount(mnuId_t id);      ///< get the number of virtual items from the user callback
+  char       *virtualItem(mnuId_t id, listId_t idx, char *buf, uint8_t bufLen, bool pad); ///< get a virtual item label from the user callback
+#endif
+  char       *ltostr(char* buf, uint8_t bufLen, int32_t v, uint8_t base, bool sign, bool leadZero = false, uint8_t decimals = 0); ///< convert long to string
   
+  bool display(userDisplayAction_t action, char *msg = nullptr); ///< send a request to the user display callback
+#if MNU_FRAME
+  void frameUpdate(userDisplayAction_t action, char *msg);  ///< compose a display request into the frame buffer
+  void frameFlush(void);    ///< send the frame buffer to the frame ready callback if it has changed
+#endif
+  value_t *valueRequest(const mnuInput_t *mInp, bool bGet); ///< send a get/set request to the input value callback
+  userNavAction_t getNav(uint16_t &incDelta); ///< get the next navigation action from the queue or user callback
+#if MNU_ACCEL
+  uint16_t accelerate(userNavAction_t nav, uint16_t incDelta); ///< apply the acceleration to a numeric input increment
+#endif
+  void feedback(const mnuInput_t *mInp);     ///< real time feedback of the edited value, rate limited
+  void feedbackSend(const mnuInput_t *mInp); ///< send the real time feedback set request
+#if MNU_ASYNC
+  void asyncCancel(void);     ///< stop waiting for an asynchronous value request
+  void asyncShow(const mnuInput_t *mInp);   ///< show the placeholder for a value being waited for
+#endif
+
   void timerStart(void);    ///< Start (reset) the timeout timer
   void timerCheck(void);    ///< Check if timeout has expired and reset menu if it has
 
   void handleMenu(bool bNew = false);  ///< handling display menu items and navigation
   void handleInput(bool bNew = false); ///< handling user input to edit values
+#if MNU_VIRTUAL_ITEMS
+  void handleVirtual(bool bNew = false); ///< handling display of virtual items and navigation
+#endif
+  void menuUpdate(bool all);  ///< show the current menu item
+  menuState_t stateCurrent(void);  ///< current state from the flags
+  void stateEnter(void);      ///< run the entry to the requested state(s)
+#if MNU_MULTI_LINE
+  viewPos_t viewNext(viewPos_t pos, bool fwd);  ///< next or previous item in the current menu or virtual list, -1 if none
+  void viewUpdate(viewPos_t curr, bool all);    ///< show the window of items for multi line displays
+#endif
 
   // Process the different types of input requests
   // All return true when edit changes are finished (SELECT or ESCAPE).
-  bool processList(userNavAction_t nav, mnuInput_t *mInp, bool rtfb);
-  bool processBool(userNavAction_t nav, mnuInput_t *mInp, bool rtfb);
-  bool processInt(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint16_t incDelta);
-  bool processFloat(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint16_t incDelta);
-  bool processEng(userNavAction_t nav, mnuInput_t *mInp, bool rtfb, uint16_t incDelta);
-  bool processRun(userNavAction_t nav, mnuInput_t *mInp, bool rtfb);
-  bool processExt(userNavAction_t nav, mnuInput_t* mInp, bool init, bool rtfb);
+  bool processList(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb);
+  bool processBool(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb);
+  bool processInt(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb, uint16_t incDelta);
+#if MNU_DIGIT_EDIT
+  bool processDigit(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb, uint16_t incDelta);
+#endif
+  bool processFloat(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb, uint16_t incDelta);
+  bool processEng(userNavAction_t nav, const mnuInput_t *mInp, bool rtfb, uint16_t incDelta);
+  bool processRun(userNavAction_t nav, const mnuInput_t *mInp);
+  bool processExt(userNavAction_t nav, const mnuInput_t *mInp, bool init, bool rtfb);
 };
 
@@ -0,0 +1,232 @@
+// Implementation file for MD_MenuStore persistent value store
+//
+// See the main header file MD_Menu.h for more information
+
+#include <MD_MenuStore.h>
+#include <MD_Menu_lib.h>
+
+/**
+ * \file
+ * \brief Code file for the MD_MenuStore persistent value store
+ */
+
+// Each image slot is the values, followed by a trailer that is written
+// last so that an interrupted write fails the check.
+const uint8_t STORE_VALUE_SIZE = 5;    ///< Stored bytes for each value, int32_t value then int8_t power
+const uint8_t STORE_TRAILER_SIZE = 4;  ///< Stored bytes for the trailer, uint16_t sequence, count and check byte
+
+MD_MenuStore::MD_MenuStore(const MD_Menu::mnuId_t *ids, uint8_t count, uint16_t size, cbStoreIO cbIO) :
+  _ids(ids), _count(count), _size(size), _cbIO(cbIO),
+  _values(nullptr), _slots(0), _slot(0), _seq(0),
+  _dirty(false), _flushPending(false), _flushDelay(0)
+{
+}
+
+MD_MenuStore::~MD_MenuStore(void)
+{
+  if (_values != nullptr)
+    free(_values);
+}
+
+uint16_t MD_MenuStore::slotSize(void)
+{
+  return((_count * STORE_VALUE_SIZE) + STORE_TRAILER_SIZE);
+}
+
+int16_t MD_MenuStore::find(MD_Menu::mnuId_t id)
+{
+  for (uint8_t i = 0; i < _count; i++)
+    if (_ids[i] == id)
+      return(i);
+
+  return(-1);
+}
+
+uint8_t MD_MenuStore::crc8(uint8_t crc, const uint8_t *data, uint16_t len)
+// CRC-8 with polynomial x^8 + x^2 + x + 1
+{
+  while (len-- != 0)
+  {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  }
+
+  return(crc);
+}
+
+bool MD_MenuStore::readSlot(uint8_t slot, uint16_t &seq, bool bLoad)
+// Check the image in the slot and return its sequence number.
+// The values are only loaded if bLoad is set.
+{
+  uint16_t addr = slot * slotSize();
+  uint8_t crc = 0;
+  uint8_t buf[STORE_VALUE_SIZE];
+
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (!_cbIO(false, addr, buf, STORE_VALUE_SIZE))
+      return(false);
+    crc = crc8(crc, buf, STORE_VALUE_SIZE);
+    addr += STORE_VALUE_SIZE;
+
+    if (bLoad)
+    {
+      _values[i].value = (int32_t)((uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24));
+      _values[i].power = (int8_t)buf[4];
+    }
+  }
+
+  if (!_cbIO(false, addr, buf, STORE_TRAILER_SIZE))
+    return(false);
+  if (buf[2] != _count || crc8(crc, buf, STORE_TRAILER_SIZE - 1) != buf[3])
+    return(false);
+
+  seq = buf[0] | (buf[1] << 8);
+
+  return(true);
+}
+
+bool MD_MenuStore::begin(void)
+{
+  bool found = false;
+
+  if (_values == nullptr)
+    _values = (MD_Menu::value_t *)malloc(_count * sizeof(MD_Menu::value_t));
+  if (_values == nullptr)
+  {
+    MD_PRINTS("\nStore begin: no memory");
+    return(false);
+  }
+  memset(_values, 0, _count * sizeof(MD_Menu::value_t));
+  _dirty = _flushPending = false;
+
+  {
+    uint16_t slots = _size / slotSize();
+
+    _slots = (_cbIO == nullptr ? 0 : (slots > 0xff ? 0xff : slots));
+  }
+
+  // find the most recent valid image
+  for (uint8_t i = 0; i < _slots; i++)
+  {
+    uint16_t seq;
+
+    if (readSlot(i, seq, false) && (!found || (int16_t)(seq - _seq) > 0))
+    {
+      found = true;
+      _slot = i;
+      _seq = seq;
+    }
+  }
+
+  if (found)
+    found = readSlot(_slot, _seq, true);
+  else
+    _slot = _slots - 1;     // so the first write goes into slot 0
+
+  return(found);
+}
+
+MD_Menu::value_t *MD_MenuStore::valueRequest(MD_Menu::mnuId_t id, bool bGet)
+{
+  int16_t i = find(id);
+
+  if (i == -1 || _values == nullptr)
+    return(nullptr);
+
+  if (!bGet)
+    _dirty = true;
+
+  return(&_values[i]);
+}
+
+bool MD_MenuStore::getValue(MD_Menu::mnuId_t id, MD_Menu::value_t &v)
+{
+  int16_t i = find(id);
+
+  if (i == -1 || _values == nullptr)
+    return(false);
+
+  v = _values[i];
+
+  return(true);
+}
+
+bool MD_MenuStore::setValue(MD_Menu::mnuId_t id, const MD_Menu::value_t &v)
+{
+  int16_t i = find(id);
+
+  if (i == -1 || _values == nullptr)
+    return(false);
+
+  if (_values[i].value != v.value || _values[i].power != v.power)
+  {
+    _values[i] = v;
+    _dirty = true;
+  }
+
+  return(true);
+}
+
+bool MD_MenuStore::flush(void)
+// Write the image into the next slot, values first and the trailer last
+{
+  uint8_t slot = (_slot + 1) % (_slots == 0 ? 1 : _slots);
+  uint16_t seq = _seq + 1;
+  uint16_t addr = slot * slotSize();
+  uint8_t crc = 0;
+  uint8_t buf[STORE_VALUE_SIZE];
+
+  _flushPending = false;
+  if (!_dirty) return(true);
+  if (_slots == 0) return(false);
+
+  MD_PRINT("\nStore flush to slot ", slot);
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    uint32_t v = (uint32_t)_values[i].value;
+
+    buf[0] = v & 0xff;
+    buf[1] = (v >> 8) & 0xff;
+    buf[2] = (v >> 16) & 0xff;
+    buf[3] = (v >> 24) & 0xff;
+    buf[4] = (uint8_t)_values[i].power;
+    crc = crc8(crc, buf, STORE_VALUE_SIZE);
+    if (!_cbIO(true, addr, buf, STORE_VALUE_SIZE))
+      return(false);
+    addr += STORE_VALUE_SIZE;
+  }
+
+  buf[0] = seq & 0xff;
+  buf[1] = (seq >> 8) & 0xff;
+  buf[2] = _count;
+  buf[3] = crc8(crc, buf, STORE_TRAILER_SIZE - 1);
+  if (!_cbIO(true, addr, buf, STORE_TRAILER_SIZE))
+    return(false);
+
+  _slot = slot;
+  _seq = seq;
+  _dirty = false;
+
+  return(true);
+}
+
+void MD_MenuStore::editEnd(void)
+{
+  if (!_dirty) return;
+
+  if (_flushDelay == 0)
+    flush();
+  else
+  {
+    _flushPending = true;
+    _timeEdit = millis();
+  }
+}
+
+void MD_MenuStore::run(void)
+{
+  if (_flushPending && millis() - _timeEdit >= _flushDelay)
+    flush();
+}
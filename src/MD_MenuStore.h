@@ -0,0 +1,169 @@
+#pragma once
+// Persistent value store for the MD_Menu library
+//
+// See the main header file MD_Menu.h for more information
+
+#include <MD_Menu.h>
+
+/**
+ * \file
+ * \brief Header file for the MD_MenuStore persistent value store
+ */
+
+/**
+ * Persistent value store for menu input values.
+ *
+ * Holds the values for a set of menu inputs in RAM, identified by the input
+ * id, and saves them to non-volatile memory (eg, EEPROM or flash) through a
+ * user callback. Edits only change the RAM copy and the stored image is
+ * written when the edit ends or the menu is exited, or after a delay that
+ * allows a number of edits to be combined into one write.
+ *
+ * The storage area is divided into as many slots as will fit, each large
+ * enough for a complete image of the values with a sequence number and a
+ * check byte. Each write uses the next slot in turn, spreading the wear over
+ * the whole area, and the image with the highest sequence number that checks
+ * correctly is loaded at startup. An interrupted write therefore leaves the
+ * previous image to be loaded.
+ */
+class MD_MenuStore
+{
+public:
+  /**
+  * Storage read/write function prototype
+  *
+  * The user function must read (bWrite false) or write (bWrite true) len
+  * bytes at the address addr in the storage area, from or to the buffer at
+  * data. Addresses are relative to the start of the storage area.
+  * Return true if the operation was successful.
+  */
+  typedef bool(*cbStoreIO)(bool bWrite, uint16_t addr, uint8_t *data, uint16_t len);
+
+  /**
+   * Class Constructor.
+   *
+   * \param ids   array of the input ids for the values held in the store. Must remain in scope.
+   * \param count number of ids in the array.
+   * \param size  size in bytes of the storage area.
+   * \param cbIO  storage read/write user callback function.
+   */
+  MD_MenuStore(const MD_Menu::mnuId_t *ids, uint8_t count, uint16_t size, cbStoreIO cbIO);
+
+  /**
+   * Class Destructor.
+   *
+   * Releases the allocated memory.
+   */
+  ~MD_MenuStore(void);
+
+  /**
+  * Initialize the object.
+  *
+  * Allocates the RAM for the values and loads the latest valid image from
+  * the storage area. If there is no valid image, all values are set to zero
+  * and the user code should set the default values using setValue().
+  *
+  * \return true if the values were loaded from storage, false otherwise.
+  */
+  bool begin(void);
+
+  /**
+  * Value request for a stored input.
+  *
+  * This has the same function as the MD_Menu cbValueRequest callback and can
+  * be returned directly by the user callback for the inputs in the store.
+  * A 'set' request marks the store as changed.
+  *
+  * \param id   the input id.
+  * \param bGet true for a 'get' request, false for a 'set' request.
+  * \return pointer to the value in the store, nullptr if the id is not in the store.
+  */
+  MD_Menu::value_t *valueRequest(MD_Menu::mnuId_t id, bool bGet);
+
+  /**
+  * Get a stored value.
+  *
+  * \param id the input id.
+  * \param v  the value is returned in this variable.
+  * \return true if the id is in the store, false otherwise.
+  */
+  bool getValue(MD_Menu::mnuId_t id, MD_Menu::value_t &v);
+
+  /**
+  * Set a stored value.
+  *
+  * The store is marked as changed if the value is different.
+  *
+  * \param id the input id.
+  * \param v  the new value.
+  * \return true if the id is in the store, false otherwise.
+  */
+  bool setValue(MD_Menu::mnuId_t id, const MD_Menu::value_t &v);
+
+  /**
+  * Set the flush delay.
+  *
+  * When the delay is set, the end of an edit only starts a timer and the
+  * values are written when no further edit has ended for the specified time,
+  * or when the menu is exited. This combines a burst of edits into one write.
+  * A value of 0 writes the values at the end of every edit (default).
+  *
+  * \param t the delay in milliseconds, 0 to disable (default).
+  */
+  void setFlushDelay(uint32_t t) { _flushDelay = t; }
+
+  /**
+  * Check if there are unsaved changes.
+  *
+  * \return true if the values have changed since they were last written.
+  */
+  bool isDirty(void) { return(_dirty); }
+
+  /**
+  * Write the values to storage.
+  *
+  * The image is written to the next slot only if the values have changed.
+  * This is called by MD_Menu at the end of the menu and can be called by
+  * user code at any time (eg, before going to sleep).
+  *
+  * \return true if the values are saved, false if the write failed.
+  */
+  bool flush(void);
+
+  /**
+  * Notify the end of an edit.
+  *
+  * Called by MD_Menu when an input edit ends. Flushes the values or starts
+  * the flush delay timer.
+  */
+  void editEnd(void);
+
+  /**
+  * Run the flush delay timer.
+  *
+  * Called by MD_Menu each time runMenu() is called. If the store is not used
+  * with a menu, this should be called each time through the loop() function.
+  */
+  void run(void);
+
+private:
+  const MD_Menu::mnuId_t *_ids; ///< Input ids for the values
+  uint8_t _count;               ///< Number of values
+  uint16_t _size;               ///< Size of the storage area in bytes
+  cbStoreIO _cbIO;              ///< User storage read/write function
+
+  MD_Menu::value_t *_values;    ///< RAM copy of the values
+  uint8_t _slots;               ///< Number of image slots in the storage area
+  uint8_t _slot;                ///< Slot with the last image written or loaded
+  uint16_t _seq;                ///< Sequence number of the last image written or loaded
+
+  bool _dirty;                  ///< Values changed since they were last written
+  bool _flushPending;           ///< Flush delay timer is running
+  uint32_t _flushDelay;         ///< Flush delay in milliseconds
+  uint32_t _timeEdit;           ///< Time the last edit ended
+
+  int16_t find(MD_Menu::mnuId_t id);  ///< position of the id in _ids[] or -1 if not found
+  uint16_t slotSize(void);            ///< size in bytes of one image slot
+  uint8_t crc8(uint8_t crc, const uint8_t *data, uint16_t len); ///< update the check byte with data
+  bool readSlot(uint8_t slot, uint16_t &seq, bool bLoad); ///< check an image slot and optionally load it
+};
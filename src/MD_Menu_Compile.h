@@ -0,0 +1,270 @@
+#pragma once
+// Compile time menu checking for MD_Menu library
+//
+// See the main header file MD_Menu.h for more information
+
+#include <MD_Menu.h>
+
+/**
+ * \file
+ * \brief Compile time validation and index generation for MD_Menu data tables
+ *
+ * The menu tables passed to the MD_Menu constructor are linked together only
+ * by id values that are resolved at run time. The definitions in this file
+ * allow the same tables to be checked by the compiler and for the id lookup
+ * index tables to be generated into PROGMEM at build time, so that the run
+ * time does no searching at all.
+ *
+ * To be usable at compile time the tables must be declared *constexpr*
+ * rather than *const*, for example
+ *
+ *     constexpr MD_Menu::mnuHeader_t mnuHdr[] PROGMEM = { ... };
+ *     constexpr MD_Menu::mnuItem_t mnuItm[] PROGMEM = { ... };
+ *     constexpr MD_Menu::mnuInput_t mnuInp[] PROGMEM = { ... };
+ *
+ *     MD_MENU_VALIDATE(mnuHdr, mnuItm, mnuInp);
+ *
+ *     MD_MENU_INDEX(idxHdr, mnuHdr);
+ *     MD_MENU_INDEX(idxItm, mnuItm);
+ *     MD_MENU_INDEX(idxInp, mnuInp);
+ *
+ * and, with MNU_INDEX enabled, the index tables are passed to the menu
+ * object using M.setIndex(idxHdr, idxItm, idxInp) before it is run.
+ *
+ * MD_MENU_VALIDATE() stops the compilation if
+ * - an id is used more than once in the same table;
+ * - a header item range is empty or its start/end ids do not exist;
+ * - a menu item refers to a menu header or input that does not exist (MNU_VIRTUAL
+ *   items are not checked as their actionId is only used by the user callback);
+ * - the menu tree, starting at the first header, is deeper than MNU_STACK_SIZE
+ *   levels. This includes any cycles in the menu tree.
+ *
+ * All the checking functions use divide and conquer recursion to keep the
+ * constexpr recursion depth proportional to log(N) of the table size.
+ */
+
+/**
+ * Compile time functions for validating and indexing MD_Menu tables.
+ *
+ * All methods are static and intended to be used through the MD_MENU_VALIDATE()
+ * and MD_MENU_INDEX() macros.
+ */
+class MD_MenuCompile
+{
+public:
+  /**
+  * Generated index position table.
+  *
+  * Holds the precompiled table position for each id in the range of a table.
+  */
+  template<size_t N> struct posTable
+  {
+    MD_Menu::mnuId_t pos[N];  ///< table position for (id - idMin), -1 if not found
+  };
+
+  /**
+  * Lowest id in a table.
+  *
+  * \param t  the data table.
+  * \return the lowest id.
+  */
+  template<typename T, size_t N>
+  static constexpr MD_Menu::mnuId_t idMin(const T (&t)[N]) { return(idMinRange(t, 0, N)); }
+
+  /**
+  * Highest id in a table.
+  *
+  * \param t  the data table.
+  * \return the highest id.
+  */
+  template<typename T, size_t N>
+  static constexpr MD_Menu::mnuId_t idMax(const T (&t)[N]) { return(idMaxRange(t, 0, N)); }
+
+  /**
+  * Number of elements in the index table for a table.
+  *
+  * \param t  the data table.
+  * \return the size of the id range covered by the table.
+  */
+  template<typename T, size_t N>
+  static constexpr size_t idRange(const T (&t)[N]) { return(idMax(t) - idMin(t) + 1); }
+
+  /**
+  * Check all ids in a table are unique.
+  *
+  * \param t  the data table.
+  * \return true if there are no duplicate ids.
+  */
+  template<typename T, size_t N>
+  static constexpr bool uniqueIds(const T (&t)[N]) { return(uniqueRange(t, 0, N)); }
+
+  /**
+  * Check all header item ranges are valid.
+  *
+  * \param hdr  the menu header table.
+  * \param itm  the menu item table.
+  * \return true if all item ranges are not empty and start/end ids exist.
+  */
+  template<size_t NH, size_t NI>
+  static constexpr bool headersValid(const MD_Menu::mnuHeader_t (&hdr)[NH], const MD_Menu::mnuItem_t (&itm)[NI])
+  { return(headersRange(hdr, itm, 0, NH)); }
+
+  /**
+  * Check all menu items refer to existing headers or inputs.
+  *
+  * \param hdr  the menu header table.
+  * \param itm  the menu item table.
+  * \param inp  the input definitions table.
+  * \return true if there are no dangling references.
+  */
+  template<size_t NH, size_t NI, size_t NP>
+  static constexpr bool itemsValid(const MD_Menu::mnuHeader_t (&hdr)[NH], const MD_Menu::mnuItem_t (&itm)[NI], const MD_Menu::mnuInput_t (&inp)[NP])
+  { return(itemsRange(hdr, itm, inp, 0, NI)); }
+
+  /**
+  * Check the menu tree fits in the menu stack.
+  *
+  * \param hdr  the menu header table.
+  * \param itm  the menu item table.
+  * \return true if no path from the root menu is deeper than MNU_STACK_SIZE.
+  */
+  template<size_t NH, size_t NI>
+  static constexpr bool depthValid(const MD_Menu::mnuHeader_t (&hdr)[NH], const MD_Menu::mnuItem_t (&itm)[NI])
+  { return(depthMenu(hdr, itm, 0, 0)); }
+
+  /**
+  * Generate the position table for a data table.
+  *
+  * \tparam R the id range of the table, from idRange().
+  * \param t  the data table.
+  * \return the table of positions.
+  */
+  template<size_t R, typename T, size_t N>
+  static constexpr posTable<R> makePos(const T (&t)[N]) { return(makePosSeq(t, idMin(t), typename makeSeq<R>::type())); }
+
+private:
+  // Compile time integer sequence, built with log(N) instantiation depth
+  template<size_t... I> struct seq { };
+  template<class S1, class S2> struct concat;
+  template<size_t... I1, size_t... I2> struct concat<seq<I1...>, seq<I2...>> { typedef seq<I1..., (sizeof...(I1) + I2)...> type; };
+  template<size_t N, int K = (N < 2 ? N : 2)> struct makeSeq { typedef typename concat<typename makeSeq<N / 2>::type, typename makeSeq<N - N / 2>::type>::type type; };
+  template<size_t N> struct makeSeq<N, 0> { typedef seq<> type; };
+  template<size_t N> struct makeSeq<N, 1> { typedef seq<0> type; };
+
+  // The results of the two halves are passed to these as parameters, so 
+  // that each half is evaluated once and not again to return it.
+  static constexpr MD_Menu::mnuId_t lower(MD_Menu::mnuId_t a, MD_Menu::mnuId_t b) { return(a < b ? a : b); }
+  static constexpr MD_Menu::mnuId_t higher(MD_Menu::mnuId_t a, MD_Menu::mnuId_t b) { return(a > b ? a : b); }
+  static constexpr int found(int a, int b) { return(a != -1 ? a : b); }
+
+  template<typename T, size_t N>
+  static constexpr MD_Menu::mnuId_t idMinRange(const T (&t)[N], size_t lo, size_t hi)
+  {
+    return(hi - lo == 1 ? t[lo].id :
+      lower(idMinRange(t, lo, (lo + hi) / 2), idMinRange(t, (lo + hi) / 2, hi)));
+  }
+
+  template<typename T, size_t N>
+  static constexpr MD_Menu::mnuId_t idMaxRange(const T (&t)[N], size_t lo, size_t hi)
+  {
+    return(hi - lo == 1 ? t[lo].id :
+      higher(idMaxRange(t, lo, (lo + hi) / 2), idMaxRange(t, (lo + hi) / 2, hi)));
+  }
+
+  // first position of id in t[lo..hi), -1 if not found
+  template<typename T, size_t N>
+  static constexpr int posOf(const T (&t)[N], MD_Menu::mnuId_t id, size_t lo, size_t hi)
+  {
+    return(hi - lo == 0 ? -1 :
+      hi - lo == 1 ? (t[lo].id == id ? (int)lo : -1) :
+      found(posOf(t, id, lo, (lo + hi) / 2), posOf(t, id, (lo + hi) / 2, hi)));
+  }
+
+  template<typename T, size_t N>
+  static constexpr bool hasId(const T (&t)[N], MD_Menu::mnuId_t id) { return(posOf(t, id, 0, N) != -1); }
+
+  template<typename T, size_t N>
+  static constexpr bool uniqueRange(const T (&t)[N], size_t lo, size_t hi)
+  {
+    return(hi - lo == 0 ? true :
+      hi - lo == 1 ? posOf(t, t[lo].id, 0, N) == (int)lo && posOf(t, t[lo].id, lo + 1, N) == -1 :
+      uniqueRange(t, lo, (lo + hi) / 2) && uniqueRange(t, (lo + hi) / 2, hi));
+  }
+
+  template<size_t NH, size_t NI>
+  static constexpr bool headersRange(const MD_Menu::mnuHeader_t (&hdr)[NH], const MD_Menu::mnuItem_t (&itm)[NI], size_t lo, size_t hi)
+  {
+    return(hi - lo == 0 ? true :
+      hi - lo == 1 ? hdr[lo].idItmStart <= hdr[lo].idItmEnd && hasId(itm, hdr[lo].idItmStart) && hasId(itm, hdr[lo].idItmEnd) :
+      headersRange(hdr, itm, lo, (lo + hi) / 2) && headersRange(hdr, itm, (lo + hi) / 2, hi));
+  }
+
+  template<size_t NH, size_t NI, size_t NP>
+  static constexpr bool itemsRange(const MD_Menu::mnuHeader_t (&hdr)[NH], const MD_Menu::mnuItem_t (&itm)[NI], const MD_Menu::mnuInput_t (&inp)[NP], size_t lo, size_t hi)
+  {
+    return(hi - lo == 0 ? true :
+      hi - lo == 1 ? (itm[lo].action == MD_Menu::MNU_MENU ? hasId(hdr, itm[lo].actionId) :
+                      itm[lo].action == MD_Menu::MNU_VIRTUAL ? true : hasId(inp, itm[lo].actionId)) :
+      itemsRange(hdr, itm, inp, lo, (lo + hi) / 2) && itemsRange(hdr, itm, inp, (lo + hi) / 2, hi));
+  }
+
+  // check the menu at header position h, displayed at stack level
+  template<size_t NH, size_t NI>
+  static constexpr bool depthMenu(const MD_Menu::mnuHeader_t (&hdr)[NH], const MD_Menu::mnuItem_t (&itm)[NI], int h, uint8_t level)
+  {
+    return(h == -1 ? true :   // dangling reference is checked elsewhere
+      level >= MNU_STACK_SIZE ? false :
+      depthItems(hdr, itm, hdr[h].idItmStart, hdr[h].idItmEnd, level, 0, NI));
+  }
+
+  // check all the submenus of items in t[lo..hi) that are in the id range of a menu
+  template<size_t NH, size_t NI>
+  static constexpr bool depthItems(const MD_Menu::mnuHeader_t (&hdr)[NH], const MD_Menu::mnuItem_t (&itm)[NI],
+    MD_Menu::mnuId_t idStart, MD_Menu::mnuId_t idEnd, uint8_t level, size_t lo, size_t hi)
+  {
+    return(hi - lo == 0 ? true :
+      hi - lo == 1 ?
+        (itm[lo].id < idStart || itm[lo].id > idEnd || itm[lo].action != MD_Menu::MNU_MENU ? true :
+          depthMenu(hdr, itm, posOf(hdr, itm[lo].actionId, 0, NH), level + 1)) :
+      depthItems(hdr, itm, idStart, idEnd, level, lo, (lo + hi) / 2) && depthItems(hdr, itm, idStart, idEnd, level, (lo + hi) / 2, hi));
+  }
+
+  template<typename T, size_t N, size_t... I>
+  static constexpr posTable<sizeof...(I)> makePosSeq(const T (&t)[N], MD_Menu::mnuId_t idMin, seq<I...>)
+  {
+    return(posTable<sizeof...(I)>{ { (MD_Menu::mnuId_t)posOf(t, (MD_Menu::mnuId_t)(idMin + I), 0, N)... } });
+  }
+};
+
+/**
+ * Validate the menu tables at compile time.
+ *
+ * Each check is a static_assert with a message describing the type of error.
+ * The tables must be declared constexpr.
+ *
+ * \param hdr the menu header table.
+ * \param itm the menu item table.
+ * \param inp the input definitions table.
+ */
+#define MD_MENU_VALIDATE(hdr, itm, inp) \
+  static_assert(MD_MenuCompile::uniqueIds(hdr), "MD_Menu: duplicate menu header id"); \
+  static_assert(MD_MenuCompile::uniqueIds(itm), "MD_Menu: duplicate menu item id"); \
+  static_assert(MD_MenuCompile::uniqueIds(inp), "MD_Menu: duplicate input id"); \
+  static_assert(MD_MenuCompile::headersValid(hdr, itm), "MD_Menu: empty or dangling menu header item range"); \
+  static_assert(MD_MenuCompile::itemsValid(hdr, itm, inp), "MD_Menu: menu item refers to undefined menu or input"); \
+  static_assert(MD_MenuCompile::depthValid(hdr, itm), "MD_Menu: menu tree deeper than MNU_STACK_SIZE or has a cycle")
+
+/**
+ * Generate an id lookup index for a menu table at compile time.
+ *
+ * Defines the position table in PROGMEM and a MD_Menu::mnuIndex_t
+ * with the specified name referencing it, for use with MD_Menu::setIndex().
+ * The table must be declared constexpr.
+ *
+ * \param name the name of the MD_Menu::mnuIndex_t object defined.
+ * \param tbl  the menu data table to index.
+ */
+#define MD_MENU_INDEX(name, tbl) \
+  static_assert(MD_MenuCompile::idRange(tbl) <= 0xffff, "MD_Menu: id range too large for an index table"); \
+  constexpr PROGMEM MD_MenuCompile::posTable<MD_MenuCompile::idRange(tbl)> name##_pos = MD_MenuCompile::makePos<MD_MenuCompile::idRange(tbl)>(tbl); \
+  const MD_Menu::mnuIndex_t name = { name##_pos.pos, MD_MenuCompile::idMin(tbl), MD_MenuCompile::idRange(tbl), true, false }
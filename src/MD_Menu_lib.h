@@ -72,11 +72,29 @@ tree is equal to three.
 #define MD_PRINTX(s, v)   ///< Library debugging output macro
 #endif
 
+#if MNU_ZERO_COPY
+#define MNU_READ_ID(v, m) { v = m; }  ///< Read an id field from a menu table
+#else
+#define MNU_READ_ID(v, m) { memcpy_P(&v, &m, sizeof(v)); }  ///< Read an id field from a menu table in PROGMEM
+#endif
+
+#if MNU_STATS
+#define STATS_INC(s) { _stats.s++; }  ///< Library statistics counter increment
+#define STATS_STACK() { stackCheck(); } ///< Library statistics stack measurement
+#else
+#define STATS_INC(s)                  ///< Library statistics counter increment
+#define STATS_STACK()                 ///< Library statistics stack measurement
+#endif
+
 const char FLD_PROMPT[] = ":";   ///< Prompt separator between input field label and left delimiter
 const char FLD_DELIM_L[] = "[";  ///< Left delimiter for variable field input
 const char FLD_DELIM_R[] = "]";  ///< Right delimiter for variable field input
 const char MNU_DELIM_L[] = "<";  ///< Left delimiter for menu option label
 const char MNU_DELIM_R[] = ">";  ///< Right delimiter for menu option label
+const char MNU_CURSOR[] = ">";   ///< Marker for the current menu option in a multi line item window. Length should be same as MNU_NOCURSOR
+const char MNU_NOCURSOR[] = " "; ///< Marker for other menu options in a multi line item window. Length should be same as MNU_CURSOR
+
+const char INP_PENDING[] = "...";  ///< Placeholder for the value while waiting for an asynchronous value request
 
 const char INP_BOOL_T[] = "Y";   ///< Boolean input True display value. Length should be same as INP_BOOL_F
 const char INP_BOOL_F[] = "N";   ///< Boolean input False display value. Length should be same as INP_BOOL_T
@@ -88,8 +106,27 @@ const char FLOAT_DECIMALS = 2;       ///< Number of float decimals implied in ui
 const char ENGU_DECIMALS = 3;        ///< Number of engineering units decimals implied in uint32_t value
 const uint8_t ENGU_RANGE = 18;       ///< Symmetrical range of power prefixes from 10^-ENGU_RANGE to 10^+ENGU_RANGE
 
-#define INP_PRE_SIZE(mi)  (strlen(mi->label) + strlen(FLD_PROMPT) + strlen(FLD_DELIM_L))  ///< Size of text pre variable display
-#define INP_POST_SIZE(mi) (strlen(FLD_DELIM_R))  ///< Size of text after variable display
+const uint16_t ACCEL_MULT[] = { 1, 10, 100, 1000 };  ///< Numeric input acceleration multiplier for each step
+
+const uint8_t INP_PRE_SIZE = INPUT_LABEL_SIZE + (sizeof(FLD_PROMPT) - 1) + (sizeof(FLD_DELIM_L) - 1);  ///< Largest size of text pre variable display
+const uint8_t INP_POST_SIZE = (sizeof(FLD_DELIM_R) - 1);  ///< Size of text after variable display
+
+// The line buffer holds the longest input field display line (with the engineering 
+// units prefix and units), menu item line or menu header label copied from the 
+// tables, and the terminating '\0'. The extra character after the field is the '\0' 
+// written by the pick list item functions.
+const uint8_t MNU_LINE_INPUT = INP_PRE_SIZE + MNU_FIELD_WIDTH_MAX + 1 + INP_POST_SIZE + 1 + MNU_UNITS_SIZE;  ///< Longest input display line
+const uint8_t MNU_LINE_ITEM = (sizeof(MNU_DELIM_L) - 1) + ITEM_LABEL_SIZE + (sizeof(MNU_DELIM_R) - 1);      ///< Longest menu item display line
+const uint8_t MNU_LINE_HEADER = HEADER_LABEL_SIZE;  ///< Longest menu header display line
+const uint8_t MNU_LINE_MAX = (MNU_LINE_INPUT > MNU_LINE_ITEM ? MNU_LINE_INPUT : MNU_LINE_ITEM);  ///< Longest input or menu item display line
+const uint8_t MNU_LINE_SIZE = (MNU_LINE_MAX > MNU_LINE_HEADER ? MNU_LINE_MAX : MNU_LINE_HEADER) + 1;      ///< Size of the shared line buffer
+
+// Input is edited digit by digit
+#if MNU_DIGIT_EDIT
+#define DIGIT_EDIT(mInp) (((mInp)->options & INP_OPT_DIGIT) != 0) ///< true if the input is edited digit by digit
+#else
+#define DIGIT_EDIT(mInp) false  ///< digit by digit editing is not included
+#endif
 
 // Global options and flags management
 #define SET_FLAG(f)   { _options |= (1<<f);  MD_PRINTX("\nSet Flag ",_options); }  ///< Set a flag
@@ -100,4 +137,11 @@ const uint8_t ENGU_RANGE = 18;       ///< Symmetrical range of power prefixes fr
 #define F_INEDIT 1    ///< Flag currently editing a value
 #define F_MENUWRAP 2  ///< Flag to wrap around ends of menu and list selections
 #define F_AUTOSTART 3 ///< Flag auto start the menu system on SEL
+#define F_DISPDIFF 4  ///< Flag send only changed parts of display lines
+#define F_DIGITNEG 5  ///< Flag value being edited by digit is negative
+#define F_INVIRT 6    ///< Flag currently displaying virtual items
+#define F_FRAMEDIRTY 7 ///< Flag frame buffer has changed since it was last sent
+#define F_FBPENDING 8 ///< Flag real time feedback set request is being held back
+#define F_ASYNCWAIT 9 ///< Flag waiting for completeValueRequest()
+#define F_ASYNCSET 10 ///< Flag the value request being waited for is a 'set'
 